@@ -0,0 +1,387 @@
+#include "RobotClip.h"
+#include "IDebug.h"
+#include "RobotServoControl.h"
+#include "RobotTrace.h"
+#include "loadClip.h"
+
+#define ANGLE_UNKNOWN 0xFF
+
+static IRobot::ClipStore clipStore;
+
+static uint8_t clip[CLIP_BUFFER_SIZE];
+static uint16_t clipLength = 0;
+static uint16_t clipSpeed = CLIP_DEFAULT_SPEED;
+
+static_assert(ROBOT_SERVOS <= CLIP_WAIT - CLIP_ABSOLUTE, "absolute records hold a 6-bit servo id");
+
+// 录制和回放不会同时进行，共用每个舵机的上一个角度
+static uint8_t lastAngle[ROBOT_SERVOS];
+
+// 录制状态
+static bool recording = false;
+static unsigned long recordStart = 0;
+static unsigned long recordTime = 0; // 已编码到片段中的时间
+
+// 回放状态
+static uint16_t playPos = 0;
+static unsigned long playStart = 0;
+static uint32_t playClipTime = 0; // 已回放到的片段时间（毫秒）
+
+// 上传状态
+static bool streaming = false;      // 缓冲区中是上传的片段
+static bool streamFinished = false; // 主机已发送完所有块
+static bool starved = false;        // 回放正在等待后续的块
+static bool chunkReceived = false;  // 本次上传已经收到过块
+static uint8_t expectedSeq = 0;
+static uint16_t chunkErrors = 0;  // 校验失败或序号错误的块
+static uint16_t chunkRetries = 0; // 缓冲区满而需要重发的块
+static uint16_t underruns = 0;    // 回放等待上传的次数
+
+// 回放的时间误差：每次等待结束时实际时间比计划晚了多少
+static uint32_t lateSum = 0;
+static uint16_t lateCount = 0;
+static uint16_t lateMax = 0;
+
+static bool put(const uint8_t *data, uint8_t length) {
+  if (clipLength + length > CLIP_BUFFER_SIZE) {
+    return false;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    clip[clipLength++] = data[i];
+  }
+  return true;
+}
+
+// 把 recordTime 到 now 之间的时间编码为等待，不足一个单位的部分留到下次
+static bool putWait(unsigned long now) {
+  unsigned long wait = now - recordTime;
+  while (wait >= CLIP_TIME_UNIT_MS) {
+    // 短等待最多 63 个单位（0xFE），64 个单位会编码成 0xFF（CLIP_WAIT_LONG）
+    if (wait > 63 * CLIP_TIME_UNIT_MS) {
+      uint16_t ms = wait > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(wait);
+      const uint8_t record[3] = {CLIP_WAIT_LONG, static_cast<uint8_t>(ms),
+                                 static_cast<uint8_t>(ms >> 8)};
+      if (!put(record, 3)) {
+        return false;
+      }
+      wait -= ms;
+      recordTime += ms;
+    } else {
+      uint8_t units = wait / CLIP_TIME_UNIT_MS;
+      const uint8_t record = CLIP_WAIT + units - 1;
+      if (!put(&record, 1)) {
+        return false;
+      }
+      wait -= units * CLIP_TIME_UNIT_MS;
+      recordTime += units * CLIP_TIME_UNIT_MS;
+    }
+  }
+  return true;
+}
+
+void startClipRecording() {
+  clipLength = 0;
+  streaming = false;
+  for (uint8_t i = 0; i < ROBOT_SERVOS; i++) {
+    lastAngle[i] = ANGLE_UNKNOWN;
+  }
+  recordStart = tickMillis();
+  recordTime = recordStart;
+  recording = true;
+  debuglnF("Clip recording started.");
+}
+
+void stopClipRecording() {
+  if (!recording) {
+    return;
+  }
+  recording = false;
+  // 保留最后一个姿态的持续时间，循环回放时节奏不变
+  putWait(tickMillis());
+  debugF("Clip recorded, bytes: ");
+  debugln(clipLength);
+}
+
+bool clipRecording() { return recording; }
+
+void clipRecordServo(int id, int angle) {
+  if (!recording || id < 0 || id >= ROBOT_SERVOS) {
+    return;
+  }
+  angle = constrain(angle, 0, 180);
+  if (angle == lastAngle[id]) {
+    return; // 目标未变化，不需要记录
+  }
+
+  bool ok = putWait(tickMillis());
+  int diff = angle - lastAngle[id];
+  if (ok && (ROBOT_SERVOS <= CLIP_DELTA_SERVOS || id < CLIP_DELTA_SERVOS) &&
+      lastAngle[id] != ANGLE_UNKNOWN && diff >= -8 && diff <= 7) {
+    const uint8_t record = CLIP_DELTA | (id << 4) | (diff & 0x0F);
+    ok = put(&record, 1);
+  } else if (ok) {
+    const uint8_t record[2] = {static_cast<uint8_t>(CLIP_ABSOLUTE | id),
+                               static_cast<uint8_t>(angle)};
+    ok = put(record, 2);
+  }
+  if (!ok) {
+    recording = false;
+    debuglnF("Clip buffer full, recording stopped.");
+    return;
+  }
+  lastAngle[id] = angle;
+}
+
+bool saveClip() {
+  if (clipLength == 0 || recording || streaming) {
+    return false;
+  }
+  clipStore.store(clip, clipLength);
+  return true;
+}
+
+bool loadClip() {
+  if (recording) {
+    return false;
+  }
+  uint16_t length = clipStore.load(clip, CLIP_BUFFER_SIZE);
+  if (length == 0) {
+    return false;
+  }
+  clipLength = length;
+  streaming = false;
+  return true;
+}
+
+void dumpClip() {
+  if (streaming) {
+    return; // 上传的片段已被回放覆盖
+  }
+  static const char digits[] = "0123456789ABCDEF";
+  for (uint16_t i = 0; i < clipLength; i++) {
+    if (i % 16 == 0) {
+      if (i != 0) {
+        Serial.println();
+      }
+      Serial.write('#');
+    }
+    Serial.write(digits[clip[i] >> 4]);
+    Serial.write(digits[clip[i] & 0x0F]);
+  }
+  if (clipLength != 0) {
+    Serial.println();
+  }
+}
+
+void setClipSpeed(uint16_t percent) { clipSpeed = percent; }
+
+uint16_t getClipSpeed() { return clipSpeed; }
+
+static uint8_t crc8(uint8_t crc, uint8_t value) {
+  crc ^= value;
+  for (uint8_t bit = 0; bit < 8; bit++) {
+    crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+  }
+  return crc;
+}
+
+void beginClipUpload() {
+  clipLength = 0;
+  playPos = 0;
+  streaming = true;
+  streamFinished = false;
+  chunkReceived = false;
+  expectedSeq = 0;
+}
+
+ClipChunkResult writeClipChunk(uint8_t seq, const uint8_t *data, uint8_t length,
+                               uint8_t crc) {
+  if (!streaming || streamFinished) {
+    return ClipChunkResult::NotUploading;
+  }
+  uint8_t check = crc8(0, seq);
+  for (uint8_t i = 0; i < length; i++) {
+    check = crc8(check, data[i]);
+  }
+  if (check != crc) {
+    chunkErrors++;
+    return ClipChunkResult::BadCrc;
+  }
+  // 确认丢失后的重发，已经写入过。还没有收到任何块时序号 255 不是重发
+  if (chunkReceived && seq == static_cast<uint8_t>(expectedSeq - 1)) {
+    return ClipChunkResult::Ok;
+  }
+  if (seq != expectedSeq) {
+    chunkErrors++;
+    return ClipChunkResult::OutOfOrder;
+  }
+  if (length > clipFreeBytes()) {
+    chunkRetries++;
+    return ClipChunkResult::Full;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    clip[clipLength++ & (CLIP_BUFFER_SIZE - 1)] = data[i];
+  }
+  chunkReceived = true;
+  expectedSeq++;
+  return ClipChunkResult::Ok;
+}
+
+void finishClipUpload() { streamFinished = true; }
+
+uint8_t clipFreeBytes() {
+  return CLIP_BUFFER_SIZE - static_cast<uint16_t>(clipLength - playPos);
+}
+
+uint8_t clipExpectedSeq() { return expectedSeq; }
+
+bool beginClipPlayback() {
+  // 上传的片段超过缓冲区时，开头已被后续的块覆盖，不能再从头回放
+  if (streaming && clipLength > CLIP_BUFFER_SIZE) {
+    return false;
+  }
+  for (uint8_t i = 0; i < ROBOT_SERVOS; i++) {
+    lastAngle[i] = ANGLE_UNKNOWN;
+  }
+  playPos = 0;
+  starved = false;
+  playClipTime = 0;
+  playStart = tickMillis();
+  return true;
+}
+
+// 当前回放位置之后的第 offset 个字节，上传的片段在缓冲区中循环存放
+static uint8_t at(uint8_t offset) {
+  return clip[(playPos + offset) & (CLIP_BUFFER_SIZE - 1)];
+}
+
+static uint8_t recordSize(uint8_t code) {
+  if (code == CLIP_WAIT_LONG) {
+    return 3;
+  }
+  if (code < CLIP_ABSOLUTE || code >= CLIP_WAIT) {
+    return 1;
+  }
+  return 2;
+}
+
+bool updateClipPlayback() {
+  unsigned long real = tickMillis() - playStart;
+  uint32_t elapsed = static_cast<uint32_t>(real) * clipSpeed / 100; // 对应的片段时间
+
+  while (true) {
+    uint16_t available = clipLength - playPos;
+    if (available == 0 || available < recordSize(at(0))) {
+      if (streaming && !streamFinished) {
+        // 上传跟不上回放，等待后续的块
+        if (!starved) {
+          starved = true;
+          underruns++;
+        }
+        return true;
+      }
+      return false; // 片段结束
+    }
+    if (starved) {
+      // 等待结束后从当前的片段时间继续，不追赶等待期间的动作
+      starved = false;
+      playStart = tickMillis() - playClipTime * 100 / clipSpeed;
+      real = tickMillis() - playStart;
+      elapsed = playClipTime;
+    }
+
+    uint8_t code = at(0);
+    if (code >= CLIP_WAIT) {
+      uint16_t wait;
+      if (code == CLIP_WAIT_LONG) {
+        wait = at(1) | (at(2) << 8);
+      } else {
+        wait = ((code & 0x3F) + 1) * CLIP_TIME_UNIT_MS;
+      }
+      if (playClipTime + wait > elapsed) {
+        return true; // 还没到下一组目标的时间
+      }
+      playClipTime += wait;
+      playPos += recordSize(code);
+
+      // 实际时间与计划时间的差
+      uint32_t planned = playClipTime * 100 / clipSpeed;
+      uint16_t late = real > planned ? static_cast<uint16_t>(real - planned) : 0;
+      lateSum += late;
+      lateCount++;
+      if (late > lateMax) {
+        lateMax = late;
+      }
+      continue;
+    }
+
+    uint8_t id;
+    int angle;
+    if (code < CLIP_ABSOLUTE) {
+      id = code >> 4;
+      int8_t diff = code & 0x0F;
+      if (diff & 0x08) {
+        diff -= 16; // 4 位有符号数
+      }
+      if (lastAngle[id] == ANGLE_UNKNOWN) {
+        return false; // 片段损坏
+      }
+      angle = lastAngle[id] + diff;
+    } else if (code < CLIP_ABSOLUTE + ROBOT_SERVOS) {
+      id = code - CLIP_ABSOLUTE;
+      angle = at(1);
+    } else {
+      return false; // 未知的记录
+    }
+    playPos += recordSize(code);
+    lastAngle[id] = angle;
+    setServo(id, angle);
+  }
+}
+
+// 片段的总时长（毫秒）
+static uint32_t clipDuration() {
+  uint32_t duration = 0;
+  if (streaming) {
+    return 0; // 上传的片段不完整地保存在缓冲区中
+  }
+  for (uint16_t i = 0; i < clipLength; i++) {
+    uint8_t code = clip[i];
+    if (code == CLIP_WAIT_LONG && i + 2 < clipLength) {
+      duration += clip[i + 1] | (clip[i + 2] << 8);
+      i += 2;
+    } else if (code >= CLIP_WAIT) {
+      duration += ((code & 0x3F) + 1) * CLIP_TIME_UNIT_MS;
+    } else if (code >= CLIP_ABSOLUTE) {
+      i++;
+    }
+  }
+  return duration;
+}
+
+void printClipStats() {
+  uint32_t duration = clipDuration();
+  Serial.println(F("Clip stats:"));
+  Serial.print(F("  recording: "));
+  Serial.println(recording ? F("yes") : F("no"));
+  Serial.print(F("  bytes: "));
+  Serial.println(clipLength);
+  Serial.print(F("  duration (ms): "));
+  Serial.println(duration);
+  Serial.print(F("  bytes per second: "));
+  Serial.println(duration ? clipLength * 1000UL / duration : 0UL);
+  Serial.print(F("  playback speed (%): "));
+  Serial.println(clipSpeed);
+  Serial.print(F("  uploading: "));
+  Serial.println(streaming && !streamFinished ? F("yes") : F("no"));
+  Serial.print(F("  chunk errors: "));
+  Serial.println(chunkErrors);
+  Serial.print(F("  chunks retried (buffer full): "));
+  Serial.println(chunkRetries);
+  Serial.print(F("  playback underruns: "));
+  Serial.println(underruns);
+  Serial.print(F("  timing error mean (ms): "));
+  Serial.println(lateCount ? lateSum / lateCount : 0UL);
+  Serial.print(F("  timing error max (ms): "));
+  Serial.println(lateMax);
+}
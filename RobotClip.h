@@ -0,0 +1,76 @@
+#ifndef ROBOT_CLIP_H
+#define ROBOT_CLIP_H
+
+#include <Arduino.h>
+#include "RobotDefines.h"
+
+// 动作片段的录制与回放
+// 录制时记录 setServo() 收到的目标角度及其时间，按增量编码写入 RAM 中的缓冲区；
+// 片段可以保存到 EEPROM 或以十六进制行输出到主机，回放动作按选定的倍速重现片段。
+// 主机也可以分块上传片段：缓冲区循环使用，回放读取已收到的部分时，
+// 空出的空间继续接收后续的块，长片段不受缓冲区大小限制。
+
+#define CLIP_BUFFER_SIZE 128     // 片段缓冲区容量（字节），必须是 2 的幂
+#define CLIP_CHUNK_MAX 16        // 上传时每块的最大字节数
+#define CLIP_TIME_UNIT_MS 4      // 短等待的时间单位
+#define CLIP_DEFAULT_SPEED 100   // 默认回放速度（百分比）
+#define CLIP_SPEED_MIN 10
+#define CLIP_SPEED_MAX 1000
+
+// 片段编码，每条记录以一个字节开头
+#define CLIP_DELTA 0x00     // 0x00-0x7F：0iiidddd，舵机 i 相对上次角度变化 dddd（-8 到 7 度）
+#define CLIP_ABSOLUTE 0x80  // 0x80-0xBF：舵机（低 6 位）后跟绝对角度
+#define CLIP_DELTA_SERVOS 8 // 增量记录只能表示前 8 个舵机，其余舵机总是记录绝对角度
+#define CLIP_WAIT 0xC0      // 0xC0-0xFE：等待 (低 6 位 + 1) * CLIP_TIME_UNIT_MS 毫秒
+#define CLIP_WAIT_LONG 0xFF // 后跟 16 位等待时间（毫秒，小端序）
+
+// 开始录制，清空缓冲区
+void startClipRecording();
+// 停止录制，记录最后一次写入到停止之间的等待
+void stopClipRecording();
+bool clipRecording();
+
+// 由 setServo() 调用，录制时记录目标角度
+void clipRecordServo(int id, int angle);
+
+// 保存到 EEPROM / 从 EEPROM 读取，返回是否成功
+bool saveClip();
+bool loadClip();
+
+// 以 "#" 开头的十六进制行输出片段
+void dumpClip();
+
+// 上传块的处理结果
+enum class ClipChunkResult : uint8_t
+{
+  Ok,
+  BadCrc,     // 校验失败，需要重发
+  OutOfOrder, // 序号不是期望的下一块
+  Full,       // 缓冲区空间不足，稍后重发
+  NotUploading
+};
+
+// 开始上传，清空缓冲区。回放可以在上传过程中开始
+void beginClipUpload();
+// 写入一块数据。crc 为序号和数据的 CRC-8（多项式 0x07）
+ClipChunkResult writeClipChunk(uint8_t seq, const uint8_t *data, uint8_t length, uint8_t crc);
+// 所有块已上传，回放读完缓冲区后结束
+void finishClipUpload();
+// 缓冲区剩余空间，主机据此决定是否发送下一块
+uint8_t clipFreeBytes();
+// 期望的下一块序号
+uint8_t clipExpectedSeq();
+
+// 回放速度（百分比，100 为原速）
+void setClipSpeed(uint16_t percent);
+uint16_t getClipSpeed();
+
+// 由回放动作调用：从头开始回放，以及每次循环推进回放，片段结束时返回 false。
+// 上传的片段超过缓冲区后开头已被覆盖，不能从头回放，beginClipPlayback 返回 false
+bool beginClipPlayback();
+bool updateClipPlayback();
+
+// 通过串口输出片段统计信息
+void printClipStats();
+
+#endif // ROBOT_CLIP_H
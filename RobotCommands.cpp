@@ -1,14 +1,23 @@
 #include "RobotCommands.h"
 #include "IDebug.h"
+#include "RobotClip.h"
 #include "RobotDefines.h"
+#include "RobotEvents.h"
+#include "RobotMemory.h"
 #include "RobotMotion.h"
+#include "RobotPower.h"
+#include "RobotRate.h"
+#include "RobotScan.h"
+#include "RobotWatchdog.h"
 #include "RobotServoControl.h"
+#include "RobotTrace.h"
 #include "loadReverse.h"
 #include "loadTrim.h"
 
 // 外部引用修剪器和反向加载器
 extern IRobot::ServoTrim trimLoader;
 extern IRobot::ServoReverse reverseLoader;
+extern IRobot::ServoPose poseLoader;
 
 const char endChar = '\r'; // 定义命令结束符
 
@@ -17,6 +26,8 @@ const char endChar = '\r'; // 定义命令结束符
 // 一般不接受参数的指令都是直接设置下一个动作ID的指令
 // 例如：'W' - 设置为行走状态，'A' - 设置为自动行走状态，'L' -
 // 设置为左转状态，'R' - 设置为右转状态，'D' - 设置为跳舞状态等。
+// 这些指令可以附带可选参数：速度 幅度 抬腿高度 循环次数，
+// 例如 "W 50 25 12 4"，省略或为 0 的参数使用动作默认值。
 class HandleCommand_MotionChange : public CommandHandler {
 public:
   RobotMotionId nextMotionId; // 下一个动作ID
@@ -25,12 +36,81 @@ public:
     nextMotionId = motionId; // 设置下一个动作ID
   }
   void handle(char *token) override {
+    // 解析可选的动作参数
+    RobotMotionParams params = {};
+    uint8_t *fields[] = {&params.speed, &params.amplitude, &params.liftHeight,
+                         &params.cycles};
+    for (uint8_t i = 0; i < 5 && *token; i++) {
+      int value = atoi(token);
+      if (i == 4) {
+        // 第 5 个参数是转向量，可以为负数，范围由 validateMotionParams 检查
+        if (value < -128 || value > 127) {
+          debuglnF("Invalid motion parameter.");
+          return;
+        }
+        params.steer = static_cast<int8_t>(value);
+        break;
+      }
+      if (value < 0 || value > 255) {
+        debuglnF("Invalid motion parameter.");
+        return;
+      }
+      *fields[i] = static_cast<uint8_t>(value);
+
+      // 跳到下一个参数
+      while (*token && *token != ' ')
+        token++;
+      while (*token == ' ')
+        token++;
+    }
+    if (!validateMotionParams(params)) {
+      return;
+    }
+
     // 处理运动状态切换命令
     debugF("Running command ");
     debug(command);
     debugF(" - Setting motion to ");
     debugln(static_cast<uint8_t>(nextMotionId));
-    setMovingState(nextMotionId); // 设置为下一个动作状态
+    setMovingState(nextMotionId, params); // 设置为下一个动作状态
+  }
+};
+
+// 按角度转向：G <角度> [速度] [幅度] [抬腿高度]，正值向左，负值向右。
+// 周期数由转向标定表换算，最后一个周期减小幅度，不多转
+class HandleCommand_G : public CommandHandler {
+public:
+  HandleCommand_G() { command = 'G'; } // 设置命令字符为 'G'
+  void handle(char *token) override {
+    int degrees = atoi(token);
+    if (degrees == 0 || degrees < -MOTION_TURN_DEGREES_MAX || degrees > MOTION_TURN_DEGREES_MAX) {
+      debuglnF("Invalid turn degrees.");
+      return;
+    }
+    RobotMotionParams params = {};
+    params.degrees = static_cast<uint8_t>(degrees < 0 ? -degrees : degrees);
+    uint8_t *fields[] = {&params.speed, &params.amplitude, &params.liftHeight};
+    for (uint8_t i = 0; i < 3; i++) {
+      // 跳到下一个参数
+      while (*token && *token != ' ')
+        token++;
+      while (*token == ' ')
+        token++;
+      if (!*token) {
+        break;
+      }
+      int value = atoi(token);
+      if (value < 0 || value > 255) {
+        debuglnF("Invalid motion parameter.");
+        return;
+      }
+      *fields[i] = static_cast<uint8_t>(value);
+    }
+    if (!validateMotionParams(params)) {
+      return;
+    }
+    setMovingState(degrees > 0 ? RobotMotionId::TurningLeft : RobotMotionId::TurningRight,
+                   params);
   }
 };
 
@@ -40,6 +120,12 @@ public:
   void handle(char *token) override {
     int index = -1, value = 0;
 
+    // 转向标定：C L|R <幅度> <周期数> <转过的角度>
+    if (*token == 'L' || *token == 'R') {
+      calibrateTurn(token);
+      return;
+    }
+
     // 解析舵机索引
     index = atoi(token);
 
@@ -65,6 +151,7 @@ public:
       trimLoader.set(index, value);
       trimLoader.store();
       trimLoader.print(); // 打印当前修剪值
+      refreshServoMapping();
 
       // 重新执行当前动作
       currentMotionState = RobotMotionState::NotStarted; // 重置状态
@@ -72,6 +159,43 @@ public:
       debuglnF("Invalid command format.");
     }
   }
+
+private:
+  // 以指定的幅度转过若干周期后，测量实际转过的角度并记录到标定表
+  static void calibrateTurn(char *token) {
+    const bool left = *token == 'L';
+    int values[3] = {}; // 幅度、周期数、角度
+    for (uint8_t i = 0; i < 3; i++) {
+      while (*token && *token != ' ')
+        token++;
+      while (*token == ' ')
+        token++;
+      if (!*token) {
+        debuglnF("Invalid command format.");
+        return;
+      }
+      values[i] = atoi(token);
+    }
+    const int step = IRobot::ServoTrim::TURN_AMPLITUDE_STEP;
+    const int point = values[0] / step - 1;
+    if (values[0] % step != 0 || point < 0 || point >= IRobot::ServoTrim::TURN_POINTS) {
+      debuglnF("Amplitude must be a calibration point (20 or 40).");
+      return;
+    }
+    if (values[1] <= 0 || values[2] <= 0 || values[2] > 720) {
+      debuglnF("Invalid cycles or degrees.");
+      return;
+    }
+    // 每个周期转过的角度，以 0.5 度为单位四舍五入
+    int halfDegrees = (values[2] * 4 / values[1] + 1) / 2;
+    if (halfDegrees <= 0 || halfDegrees >= 0xFF) {
+      debuglnF("Turn rate out of range.");
+      return;
+    }
+    trimLoader.setTurn(left, point, halfDegrees);
+    trimLoader.store();
+    trimLoader.print();
+  }
 };
 
 class HandleCommand_RV : public CommandHandler {
@@ -108,6 +232,7 @@ public:
       reverseLoader.set(index, reverse);
       reverseLoader.store();
       reverseLoader.print(); // 打印当前反向值
+      refreshServoMapping();
 
       // 重新执行当前动作
       currentMotionState = RobotMotionState::NotStarted; // 重置状态
@@ -127,7 +252,7 @@ public:
     // 解析舵机索引
     int index = atoi(token);
 
-    if (index < 0 || index >= 8) {
+    if (index < 0 || index >= ROBOT_SERVOS) {
       debuglnF("Invalid servo index.");
       return;
     }
@@ -156,23 +281,329 @@ public:
   }
 };
 
+class HandleCommand_P : public CommandHandler {
+public:
+  HandleCommand_P() { command = 'P'; } // 设置命令字符为 'P'
+  void handle(char *token) override {
+    // 设置运行参数：P <参数类别> <值>
+    char key = *token;
+
+    // 查找下一个空格
+    while (*token && *token != ' ')
+      token++;
+    if (*token != ' ') {
+      debuglnF("Invalid command format.");
+      return;
+    }
+    while (*token == ' ')
+      token++;
+    long value = atol(token);
+
+    switch (key) {
+    case 'S': // 舵机转速（度/秒）
+      if (value < 30 || value > 2000) {
+        debuglnF("Slew rate must be 30-2000 deg/s.");
+        return;
+      }
+      setServoSlewRate(static_cast<uint16_t>(value));
+      break;
+    case 'B': // 电流预算
+      if (value < SERVO_COST_LEG || value > 255) {
+        debuglnF("Current budget must be at least one leg servo.");
+        return;
+      }
+      setServoCurrentBudget(static_cast<uint8_t>(value));
+      break;
+    case 'A': // 软启动总时长（毫秒）
+      if (value < 100 || value > 5000) {
+        debuglnF("Attach budget must be 100-5000 ms.");
+        return;
+      }
+      setServoAttachBudget(static_cast<uint16_t>(value));
+      break;
+    case 'I': // 空闲超时（秒），0 表示不进入低功耗
+      if (value < 0 || value > 3600) {
+        debuglnF("Idle timeout must be 0-3600 s.");
+        return;
+      }
+      setIdleTimeout(static_cast<uint16_t>(value));
+      break;
+    case 'R': // 低功耗期间的测距间隔（毫秒），0 表示不测距
+      if (value < 0 || value > 60000) {
+        debuglnF("Ranging interval must be 0-60000 ms.");
+        return;
+      }
+      setIdleRangingInterval(static_cast<uint16_t>(value));
+      break;
+    case 'O': // 避障方式：0 轮流左右转，1 扫描后选择方向，2 边走边转
+      if (value < 0 || value > 2) {
+        debuglnF("Avoid mode must be 0-2.");
+        return;
+      }
+      setAvoidMode(static_cast<AvoidMode>(value));
+      break;
+    case 'M': // 舵机模型的更新频率（Hz）
+      if (value < 1 || value > RATE_MAX_HZ) {
+        debuglnF("Servo model rate must be 1-200 Hz.");
+        return;
+      }
+      setTaskRate(RateTask::Servos, static_cast<uint8_t>(value));
+      break;
+    case 'U': // 超声波测距频率（Hz）
+      if (value < 1 || value > RATE_US_MAX_HZ) {
+        debuglnF("Ranging rate must be 1-16 Hz.");
+        return;
+      }
+      setTaskRate(RateTask::Sensing, static_cast<uint8_t>(value));
+      break;
+    case 'D': // 显示刷新频率（Hz）
+      if (value < 1 || value > RATE_MAX_HZ) {
+        debuglnF("Display rate must be 1-200 Hz.");
+        return;
+      }
+      setTaskRate(RateTask::Display, static_cast<uint8_t>(value));
+      break;
+    default:
+      debuglnF("Unknown parameter.");
+      return;
+    }
+    debugF("Parameter ");
+    debug(key);
+    debugF(" set to ");
+    debugln(value);
+  }
+};
+
+class HandleCommand_Q : public CommandHandler {
+public:
+  HandleCommand_Q() { command = 'Q'; } // 设置命令字符为 'Q'
+  void handle(char *token) override {
+    // 查询运行状态，参数指定查询的类别，缺省为内存
+    switch (*token) {
+    case '\0':
+    case 'M':
+      printMemoryStats();
+      break;
+    case 'S':
+      printServoStats();
+      break;
+    case 'C':
+      trimLoader.print();
+      reverseLoader.print();
+      poseLoader.print();
+      break;
+    case 'P':
+      printPowerStats();
+      break;
+    case 'W':
+      printWatchdogStats();
+      break;
+    case 'E':
+      printEventStats();
+      break;
+    case 'X':
+      printTraceStats();
+      break;
+    case 'K':
+      printClipStats();
+      break;
+    case 'O':
+      printScanStats();
+      break;
+    case 'F':
+      printRateStats();
+      break;
+    default:
+      debuglnF("Unknown query.");
+      break;
+    }
+  }
+};
+
+class HandleCommand_X : public CommandHandler {
+public:
+  HandleCommand_X() { command = 'X'; } // 设置命令字符为 'X'
+  void handle(char *) override {
+    // 停止输入记录。记录只能在启动握手时开始，保证回放从已知的初始状态出发
+    if (!traceActive()) {
+      debuglnF("Not recording, send X during boot to start.");
+      return;
+    }
+    stopTrace();
+  }
+};
+
+// 解析两位十六进制数，失败时返回 -1
+static int parseHexByte(const char *text) {
+  int value = 0;
+  for (uint8_t i = 0; i < 2; i++) {
+    char c = text[i];
+    value <<= 4;
+    if (c >= '0' && c <= '9') {
+      value |= c - '0';
+    } else if (c >= 'A' && c <= 'F') {
+      value |= c - 'A' + 10;
+    } else if (c >= 'a' && c <= 'f') {
+      value |= c - 'a' + 10;
+    } else {
+      return -1;
+    }
+  }
+  return value;
+}
+
+// 上传一块片段数据：<序号> <十六进制数据> <CRC>，结果总是回复给主机
+static void handleClipChunk(char *token) {
+  uint8_t seq = static_cast<uint8_t>(atoi(token));
+  while (*token && *token != ' ')
+    token++;
+  while (*token == ' ')
+    token++;
+
+  uint8_t data[CLIP_CHUNK_MAX];
+  uint8_t length = 0;
+  int crc = -1;
+  while (*token && *token != ' ' && length < CLIP_CHUNK_MAX) {
+    int value = parseHexByte(token);
+    if (value < 0) {
+      break;
+    }
+    data[length++] = static_cast<uint8_t>(value);
+    token += 2;
+  }
+  while (*token == ' ')
+    token++;
+  crc = parseHexByte(token);
+
+  ClipChunkResult result =
+      crc < 0 ? ClipChunkResult::BadCrc
+              : writeClipChunk(seq, data, length, static_cast<uint8_t>(crc));
+  // 回复：ACK <序号> <剩余空间> 或 NAK <期望的序号> <原因>
+  if (result == ClipChunkResult::Ok) {
+    Serial.print(F("ACK "));
+    Serial.print(seq);
+    Serial.print(' ');
+    Serial.println(clipFreeBytes());
+  } else {
+    Serial.print(F("NAK "));
+    Serial.print(clipExpectedSeq());
+    Serial.print(' ');
+    Serial.println(static_cast<uint8_t>(result));
+  }
+}
+
+class HandleCommand_K : public CommandHandler {
+public:
+  HandleCommand_K() { command = 'K'; } // 设置命令字符为 'K'
+  void handle(char *token) override {
+    // 动作片段：K <操作> [参数]
+    char action = *token;
+
+    // 跳到操作后的参数
+    while (*token && *token != ' ')
+      token++;
+    while (*token == ' ')
+      token++;
+
+    switch (action) {
+    case 'R': // 开始录制
+      if (currentMotionId == RobotMotionId::Playback) {
+        debuglnF("Cannot record during playback.");
+        return;
+      }
+      startClipRecording();
+      break;
+    case 'S': // 停止录制
+      stopClipRecording();
+      break;
+    case 'W': // 保存到 EEPROM
+      if (saveClip()) {
+        debuglnF("Clip saved.");
+      } else {
+        debuglnF("No clip to save.");
+      }
+      break;
+    case 'E': // 从 EEPROM 读取
+      if (loadClip()) {
+        debuglnF("Clip loaded.");
+      } else {
+        debuglnF("No stored clip.");
+      }
+      break;
+    case 'D': // 输出到主机
+      dumpClip();
+      break;
+    case 'U': // 开始上传
+      if (clipRecording()) {
+        debuglnF("Stop recording first.");
+        return;
+      }
+      beginClipUpload();
+      Serial.print(F("ACK - "));
+      Serial.println(clipFreeBytes());
+      break;
+    case 'C': // 上传一块
+      handleClipChunk(token);
+      break;
+    case 'F': // 上传结束
+      finishClipUpload();
+      break;
+    case 'P': { // 回放：K P [速度百分比] [周期数]
+      if (clipRecording()) {
+        debuglnF("Stop recording first.");
+        return;
+      }
+      long speed = *token ? atol(token) : CLIP_DEFAULT_SPEED;
+      if (speed < CLIP_SPEED_MIN || speed > CLIP_SPEED_MAX) {
+        debuglnF("Clip speed must be 10-1000 %.");
+        return;
+      }
+      while (*token && *token != ' ')
+        token++;
+      while (*token == ' ')
+        token++;
+      int cycles = atoi(token);
+      if (cycles < 0 || cycles > 255) {
+        debuglnF("Invalid motion parameter.");
+        return;
+      }
+      RobotMotionParams params = {};
+      params.cycles = static_cast<uint8_t>(cycles);
+      setClipSpeed(static_cast<uint16_t>(speed));
+      setMovingState(RobotMotionId::Playback, params);
+      break;
+    }
+    default:
+      debuglnF("Unknown clip action.");
+      break;
+    }
+  }
+};
+
 CommandHandler *commandHandlers[] = {
     new HandleCommand_MotionChange('W', RobotMotionId::Walking),
     new HandleCommand_MotionChange('A', RobotMotionId::AutoWalking),
     new HandleCommand_MotionChange('L', RobotMotionId::TurningLeft),
     new HandleCommand_MotionChange('R', RobotMotionId::TurningRight),
     new HandleCommand_MotionChange('D', RobotMotionId::Dancing),
+    new HandleCommand_MotionChange('B', RobotMotionId::WalkingBackward),
+    new HandleCommand_G(),
     new HandleCommand_C(),
     new HandleCommand_RV(),
     new HandleCommand_T(),
+    new HandleCommand_Q(),
+    new HandleCommand_P(),
+    new HandleCommand_X(),
+    new HandleCommand_K(),
     nullptr // 结束标志
 };
 
 void handleCommands() {
-  static char buffer[32];      // 命令缓冲区
+  static char buffer[48];      // 命令缓冲区，可容纳一块片段上传数据
   static uint8_t bufIndex = 0; // 缓冲区索引
   while (Serial.available() > 0) {
     char inChar = Serial.read();
+    traceSerialByte(inChar); // 记录读取的字节，回放时按相同的顺序送入
 
     // 如果接收到了结束符或缓冲区即将溢出，则处理命令
     if (inChar == endChar || bufIndex >= sizeof(buffer) - 1) {
@@ -195,7 +626,9 @@ void handleCommands() {
           break;                             // 找到后退出循环
         }
       }
-      if (!commandFound) {
+      if (commandFound) {
+        publishEvent(RobotEventType::CommandReceived, cmd);
+      } else {
         debugF("Unknown command: ");
         debugln(buffer);
       }
@@ -208,4 +641,5 @@ void handleCommands() {
       buffer[bufIndex++] = inChar;
     }
   }
+  watchdogCheckin(WatchdogTask::Commands); // 串口输入已读完
 }
\ No newline at end of file
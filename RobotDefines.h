@@ -2,20 +2,55 @@
 #define ROBOT_DEFINES_H
 
 #include <Arduino.h>
+#include "RobotLayout.h"
 
-// 舵机引脚常量定义
-#define FRONT_RIGHT_HIP 0
-#define FRONT_LEFT_HIP 1
-#define FRONT_RIGHT_LEG 2
-#define FRONT_LEFT_LEG 3
-#define BACK_RIGHT_HIP 4
-#define BACK_LEFT_HIP 5
-#define BACK_RIGHT_LEG 6
-#define BACK_LEFT_LEG 7
+// 腿的数量：4 为四足（8 个舵机），6 为六足（12 个舵机），编译时可以用 -DROBOT_LEGS=6 选择
+#ifndef ROBOT_LEGS
+#define ROBOT_LEGS 4
+#endif
+#define ROBOT_JOINTS_PER_LEG 2 // 每条腿的关节数：髋关节和腿部
+#define ROBOT_SERVOS (ROBOT_LEGS * ROBOT_JOINTS_PER_LEG)
+
+// 舵机布局，引脚按舵机编号排列（见 RobotLayout.h）
+#if ROBOT_LEGS == 4
+typedef RobotLayout<ROBOT_LEGS, ROBOT_JOINTS_PER_LEG, 2, 8, 3, 9, 4, 6, 5, 7> BodyLayout;
+#elif ROBOT_LEGS == 6
+// 中间一对腿的舵机接在后腿之前，占用模拟引脚 A0-A3
+typedef RobotLayout<ROBOT_LEGS, ROBOT_JOINTS_PER_LEG, 2, 8, 3, 9, 14, 15, 16, 17, 4, 6, 5, 7>
+    BodyLayout;
+#else
+#error "no pin map for this number of legs"
+#endif
+static_assert(BodyLayout::servos == ROBOT_SERVOS, "layout must match ROBOT_SERVOS");
+
+typedef BodyLayout::Mask ServoMask; // 每个舵机占一位的掩码
+
+// 舵机编号常量定义
+#define FRONT_RIGHT_HIP BodyLayout::servo(0, 0)
+#define FRONT_LEFT_HIP BodyLayout::servo(1, 0)
+#define FRONT_RIGHT_LEG BodyLayout::servo(0, 1)
+#define FRONT_LEFT_LEG BodyLayout::servo(1, 1)
+#define BACK_RIGHT_HIP BodyLayout::servo(ROBOT_LEGS - 2, 0)
+#define BACK_LEFT_HIP BodyLayout::servo(ROBOT_LEGS - 1, 0)
+#define BACK_RIGHT_LEG BodyLayout::servo(ROBOT_LEGS - 2, 1)
+#define BACK_LEFT_LEG BodyLayout::servo(ROBOT_LEGS - 1, 1)
 
 #define PIN_Trigger 12
 #define PIN_Echo 11
 
+// 动作参数的有效范围
+#define MOTION_SPEED_MAX 100      // 速度百分比上限，100 表示各阶段之间不等待
+#define MOTION_PHASE_STEP_MS 5    // 速度每降低 1%，阶段间隔增加的毫秒数
+#define MOTION_AMPLITUDE_MAX 45   // 髋关节幅度上限（度）
+#define MOTION_LIFT_HEIGHT_MAX 40 // 抬腿高度上限（度）
+#define MOTION_STEER_MAX 100      // 转向量上限（百分比），100 时一侧完全不迈步
+#define MOTION_TURN_DEGREES_MAX 180 // 按角度转向时的角度上限（度）
+
+// 关节限位（度），内置步态的关键帧在编译期按动作参数的上限检查
+#define JOINT_HIP_MIN 40 // 髋关节摆动的极限，再大会与相邻的腿碰撞
+#define JOINT_HIP_MAX 140
+#define JOINT_LEG_MIN 45 // 腿部抬起的极限（腿部只会抬起，放下时位于中心位置）
+
 // 机器人动作ID枚举
 enum class RobotMotionId : uint8_t
 {
@@ -26,7 +61,11 @@ enum class RobotMotionId : uint8_t
   TurningRight,
   Dancing,
   Singing,
-  DebugUS
+  DebugUS,
+  Playback, // 回放录制的动作片段
+  Scanning, // 扫描前方扇区，选择避障的转向方向
+  WalkingBackward, // 向后走
+  Count // 动作数量，必须位于最后
 };
 
 // 机器人动作状态枚举
@@ -37,4 +76,15 @@ enum class RobotMotionState : uint8_t
   Completed
 };
 
+// 动作参数，各字段为 0 时使用该动作自身的默认值
+struct RobotMotionParams
+{
+  uint8_t speed;      // 速度百分比（1-100）
+  uint8_t amplitude;  // 髋关节幅度（度）
+  uint8_t liftHeight; // 抬腿高度（度）
+  uint8_t cycles;     // 动作循环次数
+  int8_t steer;       // 行走时的转向量（百分比），正值向左，负值向右
+  uint8_t degrees;    // 转向的目标角度（度），0 表示按循环次数转向
+};
+
 #endif // ROBOT_DEFINES_H
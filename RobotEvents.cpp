@@ -0,0 +1,140 @@
+#include "RobotEvents.h"
+#include "IDebug.h"
+#include "RobotWatchdog.h"
+
+static_assert((EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) == 0,
+              "EVENT_QUEUE_SIZE must be a power of two");
+static_assert(static_cast<uint8_t>(RobotEventType::Count) <= 8,
+              "event masks are 8 bits wide");
+
+struct EventSubscriber
+{
+  RobotEventHandler handler;
+  uint8_t typeMask;
+  uint8_t priority;
+};
+
+static RobotEvent queue[EVENT_QUEUE_SIZE];
+static uint8_t queueHead = 0; // 下一个读取位置
+static uint8_t queueTail = 0; // 下一个写入位置
+
+// 订阅者按优先级从小到大排列
+static EventSubscriber subscribers[EVENT_MAX_SUBSCRIBERS];
+static uint8_t subscriberCount = 0;
+
+// 统计
+static uint32_t eventsPublished = 0;
+static uint16_t eventsDropped = 0;  // 缓冲区满而丢弃的事件
+static uint16_t budgetDeferrals = 0; // 超出每次循环的分发数量、推迟到下次循环的次数
+static uint16_t maxDispatchUs = 0;   // 单个事件分发的最长耗时，只用于统计
+
+static uint8_t publishedMask = 0; // 上次读取后发布过的事件类型，供动作脚本等待事件
+
+bool subscribeEvents(uint8_t typeMask, uint8_t priority, RobotEventHandler handler)
+{
+  if (subscriberCount >= EVENT_MAX_SUBSCRIBERS || handler == nullptr)
+  {
+    return false;
+  }
+  // 插入排序，保持优先级顺序
+  uint8_t i = subscriberCount;
+  while (i > 0 && subscribers[i - 1].priority > priority)
+  {
+    subscribers[i] = subscribers[i - 1];
+    i--;
+  }
+  subscribers[i].handler = handler;
+  subscribers[i].typeMask = typeMask;
+  subscribers[i].priority = priority;
+  subscriberCount++;
+  return true;
+}
+
+bool publishEvent(RobotEventType type, uint8_t arg, uint16_t value)
+{
+  publishedMask |= 1 << static_cast<uint8_t>(type); // 缓冲区满时同样记录，等待者不会错过
+  uint8_t next = (queueTail + 1) & (EVENT_QUEUE_SIZE - 1);
+  if (next == queueHead)
+  {
+    eventsDropped++;
+    return false;
+  }
+  queue[queueTail].type = type;
+  queue[queueTail].arg = arg;
+  queue[queueTail].value = value;
+  queueTail = next;
+  eventsPublished++;
+  return true;
+}
+
+bool takePublishedEvent(RobotEventType type)
+{
+  const uint8_t mask = 1 << static_cast<uint8_t>(type);
+  const bool published = publishedMask & mask;
+  publishedMask &= ~mask;
+  return published;
+}
+
+void dispatchEvents(uint8_t budget)
+{
+  uint8_t dispatched = 0;
+  while (queueHead != queueTail)
+  {
+    if (dispatched >= budget)
+    {
+      budgetDeferrals++;
+      return; // 超出本次循环的数量，剩余事件留到下次循环
+    }
+    unsigned long eventStart = micros();
+
+    // 先取出事件再分发，订阅者可以继续发布新事件
+    RobotEvent event = queue[queueHead];
+    dispatched++;
+    queueHead = (queueHead + 1) & (EVENT_QUEUE_SIZE - 1);
+
+    uint8_t mask = 1 << static_cast<uint8_t>(event.type);
+    for (uint8_t i = 0; i < subscriberCount; i++)
+    {
+      if (subscribers[i].typeMask & mask)
+      {
+        subscribers[i].handler(event);
+      }
+    }
+
+    unsigned long cost = micros() - eventStart;
+    if (cost > maxDispatchUs)
+    {
+      maxDispatchUs = cost > 0xFFFF ? 0xFFFF : cost;
+    }
+  }
+  watchdogCheckin(WatchdogTask::Events); // 队列已清空
+}
+
+// 调试日志订阅者
+static void logEvent(const RobotEvent &event)
+{
+  debugF("Event ");
+  debug(static_cast<uint8_t>(event.type));
+  debugF(" arg ");
+  debug(event.arg);
+  debugF(" value ");
+  debugln(event.value);
+}
+
+void setupEventLog()
+{
+  subscribeEvents(EVENT_MASK_ALL, 200, logEvent);
+}
+
+void printEventStats()
+{
+  Serial.println(F("Event stats:"));
+  Serial.print(F("  published: "));
+  Serial.println(eventsPublished);
+  Serial.print(F("  dropped: "));
+  Serial.println(eventsDropped);
+  Serial.print(F("  budget deferrals: "));
+  Serial.println(budgetDeferrals);
+  Serial.print(F("  max dispatch (us): "));
+  Serial.println(maxDispatchUs);
+}
@@ -0,0 +1,62 @@
+#ifndef ROBOT_EVENTS_H
+#define ROBOT_EVENTS_H
+
+#include <Arduino.h>
+
+// 静态事件总线
+// 控制路径上的模块只发布事件（写入环形缓冲区），显示和日志等订阅者
+// 在主循环中稍后按优先级分发，不占用动作更新的时间。
+// 每次循环分发的事件数有上限。上限按事件数而不是按耗时计算：耗时取决于串口等外部因素，
+// 回放时无法复现，按数量计算时哪个事件在哪次循环处理与现场一致。
+
+#define EVENT_QUEUE_SIZE 8             // 环形缓冲区容量，必须是 2 的幂
+#define EVENT_MAX_SUBSCRIBERS 6        // 最多订阅者数量
+#define EVENT_DISPATCH_BUDGET 4        // 每次循环最多分发的事件数
+
+// 事件类型
+enum class RobotEventType : uint8_t
+{
+  MotionStarted,    // arg: 动作ID
+  PhaseAdvanced,    // arg: 动作ID，value: 阶段编号
+  ObstacleDetected, // arg: 将要执行的避障动作ID，value: 距离（毫米）
+  CommandReceived,  // arg: 命令字符
+  DistanceMeasured, // value: 后台测距的距离（毫米）
+  MotionRequested,  // arg: 请求的动作ID，value: 请求方式和转向角度（见 MOTION_REQUEST_VALUE）
+  Count             // 事件类型数量，必须位于最后
+};
+
+struct RobotEvent
+{
+  RobotEventType type;
+  uint8_t arg;
+  uint16_t value;
+};
+
+// 订阅者回调
+typedef void (*RobotEventHandler)(const RobotEvent &event);
+
+// 事件类型对应的订阅掩码
+#define EVENT_MASK(type) (1 << static_cast<uint8_t>(RobotEventType::type))
+#define EVENT_MASK_ALL 0xFF
+
+// 订阅事件，priority 越小越先执行，返回是否订阅成功
+bool subscribeEvents(uint8_t typeMask, uint8_t priority, RobotEventHandler handler);
+
+// 发布事件，缓冲区已满时丢弃并计数，返回 false。
+// 缓冲区会丢事件，控制上不能丢失的请求要检查返回值并重试，或直接调用对应的模块
+bool publishEvent(RobotEventType type, uint8_t arg = 0, uint16_t value = 0);
+
+// 上次调用以来是否发布过 type 类型的事件，读取后清除。
+// 不经过缓冲区，发布后立即可见，供动作脚本等待事件（同一时刻只有一个等待者）
+bool takePublishedEvent(RobotEventType type);
+
+// 分发缓冲区中的事件，最多 budget 个，其余留到下次循环，每次循环调用
+void dispatchEvents(uint8_t budget = EVENT_DISPATCH_BUDGET);
+
+// 注册调试日志订阅者
+void setupEventLog();
+
+// 通过串口输出事件统计信息
+void printEventStats();
+
+#endif // ROBOT_EVENTS_H
@@ -0,0 +1,43 @@
+#include "RobotGait.h"
+#include "RobotServoControl.h"
+
+static const uint8_t centerPos = 90; // 中心位置
+
+// 变换后第 phase 个阶段中，关键帧中的第 leg 条腿使用的关键帧
+static uint32_t legFrame(const Gait &gait, GaitTransform transform, uint8_t phase, uint8_t leg) {
+  const uint8_t length = gait.length;
+  // 倒放时第 phase 个阶段到达正放时第 length - 2 - phase 个阶段结束时的姿态，
+  // 周期开始前的姿态（最后一个关键帧）保持不变
+  uint8_t index = (transform & GAIT_REVERSE) ? (2 * length - 2 - phase) % length : phase;
+  const uint8_t offset = (transform >> (leg * 3)) & 7;
+  index = (index + length - offset % length) % length;
+  return pgm_read_dword(&gait.frames[index]);
+}
+
+void applyGaitPhase(const Gait &gait, GaitTransform transform, uint8_t phase,
+                    uint8_t rightAmplitude, uint8_t leftAmplitude, uint8_t liftHeight) {
+  const bool mirror = transform & GAIT_MIRROR;
+  phase %= gait.length;
+  const uint8_t previous = phase == 0 ? gait.length - 1 : phase - 1;
+  beginServoPose(); // 这个阶段的所有关节在同一帧内一起开始转动
+  for (uint8_t leg = 0; leg < ROBOT_LEGS; leg++) {
+    // 镜像时这条腿执行另一侧对应的腿（前右 <-> 前左，后右 <-> 后左）的动作
+    const uint8_t column = gaitColumn(leg);
+    const uint8_t source = gaitColumn(mirror ? leg ^ 1 : leg);
+    const uint32_t frame = legFrame(gait, transform, phase, column);
+    const uint32_t before = legFrame(gait, transform, previous, column);
+
+    // 取值以半个幅度为单位，整数除法向零取整，正负两个方向对称
+    int8_t hip = gaitValue(frame, gaitHip(source));
+    if (hip != gaitValue(before, gaitHip(source))) {
+      const uint8_t amplitude = leg % 2 == 0 ? rightAmplitude : leftAmplitude;
+      setServoTrusted(BodyLayout::servo(leg, 0),
+                      centerPos + (mirror ? -hip : hip) * amplitude / GAIT_FULL);
+    }
+    int8_t knee = gaitValue(frame, gaitKnee(source));
+    if (knee != gaitValue(before, gaitKnee(source))) {
+      setServoTrusted(BodyLayout::servo(leg, 1), centerPos + knee * liftHeight / GAIT_FULL);
+    }
+  }
+  commitServoPose();
+}
@@ -0,0 +1,139 @@
+#ifndef ROBOT_GAIT_H
+#define ROBOT_GAIT_H
+
+#include <Arduino.h>
+#include "RobotDefines.h"
+
+// 步态代数
+// 步态只定义一次：一个周期内每个阶段结束时的姿态（关键帧），存放在 flash 中。
+// 左右镜像、时间倒放、幅度缩放和每条腿的相位偏移在执行时作为变换应用，
+// 因此左转 / 右转、前进 / 后退等动作共用同一张表，几乎不增加 flash。
+// 关键帧表在编译期检查关节限位和抬腿规则（见下文），执行时不再限制角度
+
+#define GAIT_LEGS 4 // 关键帧描述的腿数（前后两对），顺序为前右、前左、后右、后左
+#define GAIT_FULL 2 // 关键帧中一个完整幅度对应的取值
+
+// 关键帧中每个关节占 4 位，取值为 -2 到 2，单位为半个幅度：
+// 髋关节乘以幅度的一半（正值为逆时针），腿部乘以抬腿高度的一半（-2 为完全抬起）
+constexpr uint32_t gaitJoint(uint8_t slot, int8_t value) {
+  return static_cast<uint32_t>(value & 0xF) << (slot * 4);
+}
+
+// 关键帧中第 leg 条腿第 joint 个关节（0 为髋关节，1 为腿部）的位置，排列与四足的舵机编号相同
+constexpr uint8_t gaitSlot(uint8_t leg, uint8_t joint) {
+  return leg / 2 * 4 + joint * 2 + leg % 2;
+}
+constexpr uint8_t gaitHip(uint8_t leg) {
+  return gaitSlot(leg, 0);
+}
+constexpr uint8_t gaitKnee(uint8_t leg) {
+  return gaitSlot(leg, 1);
+}
+
+// 按腿的顺序给出髋关节和腿部的取值，生成一个关键帧
+constexpr uint32_t gaitPose(int8_t frontRightHip, int8_t frontLeftHip, int8_t backRightHip,
+                            int8_t backLeftHip, int8_t frontRightLeg, int8_t frontLeftLeg,
+                            int8_t backRightLeg, int8_t backLeftLeg) {
+  return gaitJoint(gaitHip(0), frontRightHip) | gaitJoint(gaitHip(1), frontLeftHip) |
+         gaitJoint(gaitHip(2), backRightHip) | gaitJoint(gaitHip(3), backLeftHip) |
+         gaitJoint(gaitKnee(0), frontRightLeg) | gaitJoint(gaitKnee(1), frontLeftLeg) |
+         gaitJoint(gaitKnee(2), backRightLeg) | gaitJoint(gaitKnee(3), backLeftLeg);
+}
+
+// 关键帧中某个关节的取值
+constexpr int8_t gaitValue(uint32_t frame, uint8_t slot) {
+  return static_cast<int8_t>(((frame >> (slot * 4)) & 0xF) ^ 8) - 8;
+}
+
+// 机器人的第 leg 条腿执行关键帧中哪条腿的动作：最前一对执行前腿，之后各对交替执行后腿和前腿。
+// 四足时一一对应；六足时中间一对执行后腿、最后一对执行前腿，对角步态成为三角步态。
+// 同侧的腿取同侧的值，髋关节的方向保持一致
+constexpr uint8_t gaitColumn(uint8_t leg) {
+  return ROBOT_LEGS == GAIT_LEGS ? leg : leg / 2 % 2 * 2 + leg % 2;
+}
+
+// 取值为 value 的关节在参数取上限时的角度（度），与执行时的换算一致
+constexpr int gaitAngle(int8_t value, uint8_t scaleMax) {
+  return 90 + value * scaleMax / GAIT_FULL;
+}
+
+//-=========== 编译期检查 ===========
+// 以下函数只在 static_assert 中使用，C++11 的 constexpr 函数只能由一条 return 构成，因此用递归遍历
+
+// 关节限位：幅度和抬腿高度取允许的最大值（validateMotionParams 的上限）时，
+// 每个关键帧的每个关节仍在限位之内，且腿部只会抬起
+constexpr bool gaitPoseWithinLimits(uint32_t frame, uint8_t leg = 0) {
+  return leg == GAIT_LEGS ||
+         (gaitAngle(gaitValue(frame, gaitHip(leg)), MOTION_AMPLITUDE_MAX) <= JOINT_HIP_MAX &&
+          gaitAngle(gaitValue(frame, gaitHip(leg)), MOTION_AMPLITUDE_MAX) >= JOINT_HIP_MIN &&
+          gaitAngle(-gaitValue(frame, gaitHip(leg)), MOTION_AMPLITUDE_MAX) <= JOINT_HIP_MAX &&
+          gaitAngle(-gaitValue(frame, gaitHip(leg)), MOTION_AMPLITUDE_MAX) >= JOINT_HIP_MIN &&
+          gaitValue(frame, gaitKnee(leg)) <= 0 &&
+          gaitAngle(gaitValue(frame, gaitKnee(leg)), MOTION_LIFT_HEIGHT_MAX) >= JOINT_LEG_MIN &&
+          gaitPoseWithinLimits(frame, leg + 1));
+}
+
+template <uint8_t N>
+constexpr bool gaitWithinLimits(const uint32_t (&frames)[N], uint8_t i = 0) {
+  return i == N || (gaitPoseWithinLimits(frames[i]) && gaitWithinLimits(frames, i + 1));
+}
+
+// 所有腿都着地
+constexpr bool gaitAllPlanted(uint32_t frame, uint8_t leg = 0) {
+  return leg == GAIT_LEGS ||
+         (gaitValue(frame, gaitKnee(leg)) == 0 && gaitAllPlanted(frame, leg + 1));
+}
+
+// 抬腿规则：同一条腿的髋关节和腿部不在同一阶段改变（脚不会在半空中拖地迈步）；
+// 髋关节只在这条腿抬起时摆动，或者在所有腿着地时一起摆动推动身体
+constexpr bool gaitStepClear(uint32_t before, uint32_t after, uint8_t leg = 0) {
+  return leg == GAIT_LEGS ||
+         ((gaitValue(before, gaitHip(leg)) == gaitValue(after, gaitHip(leg)) ||
+           (gaitValue(before, gaitKnee(leg)) == gaitValue(after, gaitKnee(leg)) &&
+            (gaitValue(after, gaitKnee(leg)) < 0 || gaitAllPlanted(after)))) &&
+          gaitStepClear(before, after, leg + 1));
+}
+
+// 行走类步态的每个阶段（包括从最后一帧回到第一帧）都满足抬腿规则。
+// 镜像和倒放不改变这一性质，相位偏移则可能破坏它
+template <uint8_t N>
+constexpr bool gaitClearance(const uint32_t (&frames)[N], uint8_t i = 0) {
+  return i == N ||
+         (gaitStepClear(frames[i == 0 ? N - 1 : i - 1], frames[i]) && gaitClearance(frames, i + 1));
+}
+
+// 步态定义：frames 指向 flash 中的 length 个关键帧
+struct Gait {
+  const uint32_t *frames;
+  uint8_t length;
+};
+
+// 由关键帧表生成步态定义，长度由数组推导
+template <uint8_t N>
+constexpr Gait gaitOf(const uint32_t (&frames)[N]) {
+  return Gait{frames, N};
+}
+
+// 步态变换，16 位：低 12 位为关键帧中每条腿的相位偏移（每条腿 3 位，0-7 个阶段，该腿的动作推迟相应的阶段，
+// 执行这条腿动作的各条腿一起推迟，见 gaitColumn），
+// 另有左右镜像和时间倒放两个标志。镜像和倒放都是对合变换，两次应用即还原，可以用异或组合
+typedef uint16_t GaitTransform;
+
+#define GAIT_IDENTITY 0x0000
+#define GAIT_MIRROR 0x1000  // 左右镜像：交换左右两侧的腿，并反转髋关节方向，例如左转变为右转
+#define GAIT_REVERSE 0x2000 // 时间倒放：按相反的顺序经过各个姿态，例如向前走变为向后走
+
+// 关键帧中的第 leg 条腿推迟 phases 个阶段
+constexpr GaitTransform gaitLegOffset(uint8_t leg, uint8_t phases) {
+  return static_cast<GaitTransform>((phases & 7) << (leg * 3));
+}
+
+// 执行变换后步态的第 phase 个阶段：只写入与上一阶段相比发生变化的舵机。
+// 髋关节按所在一侧的幅度缩放（左右幅度不同时边走边转），腿部按抬腿高度缩放。
+// 幅度和抬腿高度不得超过 MOTION_AMPLITUDE_MAX 和 MOTION_LIFT_HEIGHT_MAX，
+// 角度由编译期检查保证在关节限位之内，直接输出，不再限制
+// 一个阶段的所有关节在同一帧内一起开始转动（见 beginServoPose）
+void applyGaitPhase(const Gait &gait, GaitTransform transform, uint8_t phase,
+                    uint8_t rightAmplitude, uint8_t leftAmplitude, uint8_t liftHeight);
+
+#endif // ROBOT_GAIT_H
@@ -0,0 +1,70 @@
+#ifndef ROBOT_LAYOUT_H
+#define ROBOT_LAYOUT_H
+
+#include <Arduino.h>
+
+// 腿和舵机的布局
+// 腿按左右成对、从前往后编号：第 leg 条腿位于第 leg / 2 对，偶数在右侧、奇数在左侧。
+// 舵机也按对编号：每对先是两条腿的第 0 个关节（髋关节），再是第 1 个关节（腿部），依此类推。
+// 四足时与原来的编号一致（0 前右髋、1 前左髋、2 前右腿……7 后左腿）。
+// 腿的数量、每条腿的关节数和引脚表都是模板参数：存储按舵机数量静态分配，
+// 编号换算是 constexpr，编译期折叠为常量，不增加运行时开销。
+
+// 能容纳 Bits 位的最小无符号整数类型，用作舵机的位掩码
+template <uint8_t Bits, bool Byte = (Bits <= 8), bool Word = (Bits <= 16)>
+struct LayoutMask {
+  typedef uint32_t type;
+};
+template <uint8_t Bits, bool Word>
+struct LayoutMask<Bits, true, Word> {
+  typedef uint8_t type;
+};
+template <uint8_t Bits>
+struct LayoutMask<Bits, false, true> {
+  typedef uint16_t type;
+};
+
+// Pins 按舵机编号依次给出每个舵机的引脚
+template <uint8_t Legs, uint8_t JointsPerLeg, uint8_t... Pins>
+struct RobotLayout {
+  static constexpr uint8_t legs = Legs;
+  static constexpr uint8_t jointsPerLeg = JointsPerLeg;
+  static constexpr uint8_t servos = Legs * JointsPerLeg;
+
+  static_assert(Legs >= 4 && Legs % 2 == 0, "legs come in left/right pairs, at least two pairs");
+  static_assert(JointsPerLeg >= 2, "gaits drive a hip and a leg joint on every leg");
+  static_assert(servos <= 32, "servo masks are at most 32 bits wide");
+  static_assert(sizeof...(Pins) == servos, "the pin map must give one pin per servo");
+
+  // 每个舵机占一位的掩码
+  typedef typename LayoutMask<servos>::type Mask;
+
+  // 第 leg 条腿第 joint 个关节的舵机
+  static constexpr uint8_t servo(uint8_t leg, uint8_t joint) {
+    return leg / 2 * (2 * JointsPerLeg) + joint * 2 + leg % 2;
+  }
+  // 舵机所在的腿和关节
+  static constexpr uint8_t legOf(uint8_t servo) {
+    return servo / (2 * JointsPerLeg) * 2 + servo % 2;
+  }
+  static constexpr uint8_t jointOf(uint8_t servo) {
+    return servo % (2 * JointsPerLeg) / 2;
+  }
+  // 舵机在掩码中的位
+  static constexpr Mask bit(uint8_t servo) {
+    return static_cast<Mask>(1) << servo;
+  }
+
+  // 舵机的引脚，引脚表位于 flash
+  static uint8_t pin(uint8_t servo) {
+    return pgm_read_byte(&pins[servo]);
+  }
+
+private:
+  static const uint8_t pins[servos] PROGMEM;
+};
+
+template <uint8_t Legs, uint8_t JointsPerLeg, uint8_t... Pins>
+const uint8_t RobotLayout<Legs, JointsPerLeg, Pins...>::pins[] PROGMEM = {Pins...};
+
+#endif // ROBOT_LAYOUT_H
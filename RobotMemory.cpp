@@ -0,0 +1,87 @@
+#include "RobotMemory.h"
+#include "IDebug.h"
+
+#if defined(__AVR__)
+// 链接器提供的内存布局符号
+extern uint8_t __data_start;
+extern uint8_t __data_end;
+extern uint8_t __bss_start;
+extern uint8_t __bss_end;
+extern uint8_t __heap_start;
+extern uint8_t _end;
+extern uint8_t __stack;
+extern char *__brkval;
+
+// 在 .init1 段执行，此时栈指针尚未初始化，所以只能使用汇编且不能调用函数
+void paintStack() __attribute__((naked, used, section(".init1")));
+void paintStack() {
+  __asm volatile("    ldi r30, lo8(_end)\n"
+                 "    ldi r31, hi8(_end)\n"
+                 "    ldi r24, %0\n"
+                 "    ldi r25, hi8(__stack)\n"
+                 "    rjmp 2f\n"
+                 "1:  st Z+, r24\n"
+                 "2:  cpi r30, lo8(__stack)\n"
+                 "    cpc r31, r25\n"
+                 "    brlo 1b\n"
+                 "    breq 1b\n" ::"i"(STACK_CANARY));
+}
+#endif
+
+static int minFree = 0x7FFF; // 见到的最小空闲内存
+
+int freeMemory() {
+#if defined(__AVR__)
+  uint8_t top; // 局部变量的地址近似为当前栈顶
+  uint8_t *heapEnd = __brkval ? reinterpret_cast<uint8_t *>(__brkval)
+                              : &__heap_start;
+  return static_cast<int>(&top - heapEnd);
+#else
+  return 0;
+#endif
+}
+
+uint16_t stackUnusedBytes() {
+#if defined(__AVR__)
+  const uint8_t *p = __brkval ? reinterpret_cast<uint8_t *>(__brkval) : &_end;
+  uint16_t count = 0;
+  // 从堆顶向上扫描，直到遇到被栈覆盖过的字节
+  while (p <= &__stack && *p == STACK_CANARY) {
+    p++;
+    count++;
+  }
+  return count;
+#else
+  return 0;
+#endif
+}
+
+void updateMemoryStats() {
+  int current = freeMemory();
+  if (current < minFree) {
+    minFree = current;
+  }
+}
+
+int minFreeMemory() { return minFree; }
+
+void printMemoryStats() {
+  Serial.println(F("Memory stats (bytes):"));
+#if defined(__AVR__)
+  Serial.print(F("  .data: "));
+  Serial.println(static_cast<unsigned int>(&__data_end - &__data_start));
+  Serial.print(F("  .bss: "));
+  Serial.println(static_cast<unsigned int>(&__bss_end - &__bss_start));
+  Serial.print(F("  heap used: "));
+  Serial.println(__brkval ? static_cast<unsigned int>(
+                                reinterpret_cast<uint8_t *>(__brkval) -
+                                &__heap_start)
+                          : 0u);
+#endif
+  Serial.print(F("  free now: "));
+  Serial.println(freeMemory());
+  Serial.print(F("  free min seen: "));
+  Serial.println(minFreeMemory());
+  Serial.print(F("  stack never used: "));
+  Serial.println(stackUnusedBytes());
+}
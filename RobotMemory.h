@@ -0,0 +1,26 @@
+#ifndef ROBOT_MEMORY_H
+#define ROBOT_MEMORY_H
+
+#include <Arduino.h>
+
+// 内存使用统计
+// 启动时（.init1 段）用金丝雀值填充 .bss 末尾到栈顶之间的空闲内存，
+// 之后通过扫描未被覆盖的金丝雀值得到栈的最高水位。
+#define STACK_CANARY 0xC5
+
+// 当前堆顶与栈顶之间的空闲字节数
+int freeMemory();
+
+// 从未被栈或堆使用过的字节数（栈最高水位以下的剩余空间）
+uint16_t stackUnusedBytes();
+
+// 每次循环调用，记录运行期间见到的最小空闲内存
+void updateMemoryStats();
+
+// 运行期间见到的最小空闲内存
+int minFreeMemory();
+
+// 通过串口输出内存统计信息
+void printMemoryStats();
+
+#endif // ROBOT_MEMORY_H
@@ -1,8 +1,17 @@
 #include "RobotMotion.h"
 #include "IDebug.h"
+#include "RobotClip.h"
+#include "RobotEvents.h"
+#include "RobotGait.h"
 #include "RobotOLED.h"
+#include "RobotScan.h"
 #include "RobotServoControl.h"
+#include "RobotTrace.h"
 #include "RobotUS.h"
+#include "RobotWatchdog.h"
+#include "loadTrim.h"
+
+extern IRobot::ServoTrim trimLoader;
 
 // 全局运动状态变量定义
 RobotMotionId currentMotionId = RobotMotionId::Idle; // 当前动作ID
@@ -10,12 +19,127 @@ RobotMotionId nextMotionId = RobotMotionId::Idle;    // 下一个动作ID
 RobotMotionState currentMotionState =
     RobotMotionState::NotStarted; // 当前动作状态
 uint16_t sharedCounter = 0;       // 共享的计数器
+static int8_t cycleSteer = 0;     // 当前行走周期的转向量
+static uint16_t turnPlanCycles = 0;       // 本次转向的周期数，按角度转向时包括最后一个不完整的周期
+static uint8_t turnPlanAmplitude = 0;     // 转向完整周期的髋关节幅度
+static uint8_t turnPlanLastAmplitude = 0; // 最后一个周期的髋关节幅度
+RobotMotionParams currentMotionParams = {}; // 当前动作参数
+RobotMotionParams nextMotionParams = {};    // 下一个动作参数
+
+//-=========== 步态定义 ===========
+// 每个关键帧是该阶段结束时的姿态，依次为四个髋关节（前右、前左、后右、后左）
+// 和四条腿的取值，以半个幅度为单位：髋关节 ±2 为完整幅度，腿部 -2 为完全抬起。
+// 每张表都在编译期检查关节限位，行走类步态还检查抬腿规则（见 RobotGait.h）
+
+// 行走：两组对角腿交替抬起、向前迈步、放下，最后所有髋关节同时回中推动身体前进。
+// 倒放即为向后走
+static constexpr uint32_t walkFrames[] PROGMEM = {
+    gaitPose(0, 0, 0, 0, -2, 0, 0, -2),   // 抬起前右腿和后左腿
+    gaitPose(2, 0, 0, -2, -2, 0, 0, -2),  // 前右腿和后左腿向前迈步
+    gaitPose(2, 0, 0, -2, 0, 0, 0, 0),    // 放下前右腿和后左腿
+    gaitPose(2, 0, 0, -2, 0, 0, 0, 0),    // 稍作停顿，准备移动身体
+    gaitPose(2, 0, 0, -2, 0, -2, -2, 0),  // 抬起前左腿和后右腿
+    gaitPose(2, -2, 2, -2, 0, -2, -2, 0), // 前左腿和后右腿向前迈步
+    gaitPose(2, -2, 2, -2, 0, 0, 0, 0),   // 放下前左腿和后右腿
+    gaitPose(0, 0, 0, 0, 0, 0, 0, 0),     // 所有髋关节回中，准备下一个循环
+};
+static_assert(gaitWithinLimits(walkFrames), "walk gait exceeds the joint limits");
+static_assert(gaitClearance(walkFrames), "walk gait drags a foot");
+static const Gait walkGait = gaitOf(walkFrames);
+// applyGaitPhase 只写入与上一个关键帧不同的关节，从四脚着地、关节回中的姿态只能进入
+// 上一个关键帧就是这个姿态的阶段，即周期开始的阶段 0（见自动行走的 handleResume）
+static_assert(walkFrames[sizeof(walkFrames) / sizeof(walkFrames[0]) - 1] ==
+                  gaitPose(0, 0, 0, 0, 0, 0, 0, 0),
+              "the walk cycle must start from the centred pose");
+
+// 左转：抬起所有腿后髋关节顺时针转，放下再抬起，回中后放下。镜像即为右转
+static constexpr uint32_t turnFrames[] PROGMEM = {
+    gaitPose(0, 0, 0, 0, -2, -2, -2, -2),     // 抬起所有腿
+    gaitPose(-2, -2, -2, -2, -2, -2, -2, -2), // 所有髋关节向左转
+    gaitPose(-2, -2, -2, -2, 0, 0, 0, 0),     // 放下所有腿
+    gaitPose(-2, -2, -2, -2, -2, -2, -2, -2), // 再次抬起所有腿
+    gaitPose(0, 0, 0, 0, -2, -2, -2, -2),     // 所有髋关节回到中心位置
+    gaitPose(0, 0, 0, 0, 0, 0, 0, 0),         // 放下所有腿
+};
+static_assert(gaitWithinLimits(turnFrames), "turn gait exceeds the joint limits");
+static_assert(gaitClearance(turnFrames), "turn gait drags a foot");
+static const Gait turnGait = gaitOf(turnFrames);
+
+// 舞蹈：原地摆动，不移动身体，因此只检查关节限位
+static constexpr uint32_t danceFrames[] PROGMEM = {
+    gaitPose(0, 0, 0, 0, -1, -1, -1, -1),     // 准备姿势 - 稍微抬起所有腿
+    gaitPose(0, 0, 0, 0, 0, 0, -2, -2),       // 前腿下压，后腿抬起
+    gaitPose(2, -2, 2, -2, 0, 0, -2, -2),     // 髋关节左右摆动
+    gaitPose(-2, 2, -2, 2, 0, 0, -2, -2),     // 髋关节反向摆动
+    gaitPose(-2, 2, -2, 2, -2, -2, 0, 0),     // 前腿抬起，后腿下压
+    gaitPose(-2, 2, -2, 2, -2, 0, 0, -2),     // 对角线动作 - 前右和后左抬高
+    gaitPose(-2, 2, -2, 2, 0, -2, -2, 0),     // 对角线动作 - 前左和后右抬高
+    gaitPose(-1, -1, -1, -1, 0, -2, -2, 0),   // 全身"抖动" - 所有髋关节左转
+    gaitPose(1, 1, 1, 1, 0, -2, -2, 0),       // 全身"抖动" - 所有髋关节右转
+    gaitPose(-1, -1, -1, -1, 0, -2, -2, 0),   // 再次全身"抖动" - 所有髋关节左转
+    gaitPose(0, 0, 0, 0, 0, -2, -2, 0),       // 结束动作 - 髋关节回中
+    gaitPose(0, 0, 0, 0, 0, 0, 0, 0),         // 结束动作 - 腿部回中
+};
+static_assert(gaitWithinLimits(danceFrames), "dance exceeds the joint limits");
+static const Gait danceGait = gaitOf(danceFrames);
+
+// 所有舵机转到同一角度，在同一帧内一起生效
+static void setAllServos(int angle) {
+  beginServoPose();
+  for (int i = 0; i < ROBOT_SERVOS; i++) {
+    setServo(i, angle);
+  }
+  commitServoPose();
+}
+
+// 被避障等动作打断的动作及其计数器，打断它的动作完成后从这里恢复；Count 表示没有
+static RobotMotionId suspendedMotionId = RobotMotionId::Count;
+static uint16_t suspendedCounter = 0;
+
+// 打断当前动作，立即转入 motion（见下面的定义）
+static void suspendCurrentMotion(RobotMotionId motion);
 
-void setMovingState(RobotMotionId motionId) {
+void setMovingState(RobotMotionId motionId, const RobotMotionParams &params) {
   // 设置下一个动作ID
   nextMotionId = motionId;
+  nextMotionParams = params;
+  suspendedMotionId = RobotMotionId::Count; // 新的动作指令不再恢复被打断的动作
   debugF("Setting motion to: ");
   debugln(static_cast<uint8_t>(motionId));
+
+  // 目标动作正在执行时，直接更新参数，无需重新开始动作
+  if (motionId == currentMotionId) {
+    currentMotionParams = params;
+  }
+}
+
+bool validateMotionParams(const RobotMotionParams &params) {
+  if (params.speed > MOTION_SPEED_MAX) {
+    debugF("Invalid speed, max is ");
+    debugln(MOTION_SPEED_MAX);
+    return false;
+  }
+  if (params.amplitude > MOTION_AMPLITUDE_MAX) {
+    debugF("Invalid amplitude, max is ");
+    debugln(MOTION_AMPLITUDE_MAX);
+    return false;
+  }
+  if (params.liftHeight > MOTION_LIFT_HEIGHT_MAX) {
+    debugF("Invalid lift height, max is ");
+    debugln(MOTION_LIFT_HEIGHT_MAX);
+    return false;
+  }
+  if (params.steer > MOTION_STEER_MAX || params.steer < -MOTION_STEER_MAX) {
+    debugF("Invalid steer, max is ");
+    debugln(MOTION_STEER_MAX);
+    return false;
+  }
+  if (params.degrees > MOTION_TURN_DEGREES_MAX) {
+    debugF("Invalid turn degrees, max is ");
+    debugln(MOTION_TURN_DEGREES_MAX);
+    return false;
+  }
+  return true;
 }
 
 bool haveNextMotion() {
@@ -35,6 +159,7 @@ void SyncMovingState() {
     if (currentMotionState == RobotMotionState::Completed) {
       debuglnF("Current motion is completed, updating to next motion.");
       currentMotionId = nextMotionId;                    // 更新当前动作ID
+      currentMotionParams = nextMotionParams;            // 更新当前动作参数
       currentMotionState = RobotMotionState::NotStarted; // 重置状态
       return;
     }
@@ -44,14 +169,10 @@ void SyncMovingState() {
 //-=========== 定义动作处理函数 ===========
 class MotionHandler_Idle : public MotionHandler {
 public:
-  MotionHandler_Idle() { motionId = RobotMotionId::Idle; }
   void handleNotStarted() override {
-    showFace("happy"); // 显示默认表情
     debuglnF("Robot is idle.");
     // 所有的脚都设置为90度
-    for (int i = 0; i < 8; i++) {
-      setServo(i, 90);
-    }
+    setAllServos(90);
     sharedCounter = 0;                                 // 重置共享计数器
     currentMotionState = RobotMotionState::InProgress; // 设置为进行中状态
   }
@@ -59,93 +180,69 @@ public:
     // 如果已经处于进行中状态，可以添加其他逻辑
     debuglnF("Robot is still idle.");
 
+    // 舵机回到空闲姿态后保存为下次上电的起始姿态；
+    // 等待到位超时时舵机还在转动，留到完成状态中到位后再保存
+    poseSaved = saveServoPose();
+
     currentMotionState = RobotMotionState::Completed; // 设置为完成状态
   }
   void handleCompleted() override {
+    if (!poseSaved) {
+      poseSaved = saveServoPose();
+    }
     sharedCounter++; // 增加计数器
     if (sharedCounter == 30) {
-      showFace("sleepy"); // 显示困倦表情
+      publishEvent(RobotEventType::PhaseAdvanced,
+                   static_cast<uint8_t>(RobotMotionId::Idle), 1); // 进入困倦阶段
       debuglnF("Robot is now sleepy.");
     }
   }
+
+private:
+  bool poseSaved = false; // 本次空闲的姿态是否已经保存
 };
 
+// 行走：向前走或倒放步态向后走
 class MotionHandler_Walking : public MotionHandler {
 public:
-  MotionHandler_Walking() { motionId = RobotMotionId::Walking; }
-  const uint8_t amplitude = 20;     // 髋关节运动幅度
-  const uint8_t legLiftHeight = 10; // 腿抬起高度
-  const uint8_t centerPos = 90;     // 中心位置
+  static constexpr uint8_t defaultCycles = 8; // 默认行走周期数
+
+  explicit MotionHandler_Walking(GaitTransform transform) : transform(transform) {}
   
   void handleNotStarted() override {
     debuglnF("Robot starts walking.");
     debugF("Walking with amplitude: ");
-    debug(amplitude);
+    debug(paramAmplitude(defaultAmplitude));
     debuglnF(" degrees");
 
     sharedCounter = 0;
     // 初始化所有舵机位置，准备行走
-    for (int i = 0; i < 8; i++) {
-      setServo(i, centerPos); // 所有舵机回到中心位置
-    }
+    setAllServos(centerPos); // 所有舵机回到中心位置
     currentMotionState = RobotMotionState::InProgress;
   }
   
   void handleInProgress() override {
+    const uint8_t amplitude = paramAmplitude(defaultAmplitude);
+    const uint8_t legLiftHeight = paramLiftHeight(defaultLegLiftHeight);
+
     // 机器人行走循环
     // 使用sharedCounter来决定当前的行走阶段
     uint8_t walkPhase = sharedCounter % 8; // 将行走分为8个阶段
 
     debugF("Walking phase: ");
     debugln(walkPhase);
+    publishEvent(RobotEventType::PhaseAdvanced,
+                 static_cast<uint8_t>(currentMotionId), walkPhase);
 
-    switch (walkPhase) {
-    case 0:                 // 准备抬起前右腿和后左腿
-      showFace("thinking"); // 显示思考表情
-      setServo(FRONT_RIGHT_LEG, centerPos - legLiftHeight); // 抬起前右腿
-      setServo(BACK_LEFT_LEG, centerPos - legLiftHeight);   // 抬起后左腿
-      break;
-    case 1: // 前右腿和后左腿向前迈步
-      setServo(FRONT_RIGHT_HIP, centerPos + amplitude); // 前右髋关节向前
-      setServo(BACK_LEFT_HIP, centerPos - amplitude);   // 后左髋关节向前
-      break;
-    case 2:                                 // 放下前右腿和后左腿
-      setServo(FRONT_RIGHT_LEG, centerPos); // 放下前右腿
-      setServo(BACK_LEFT_LEG, centerPos);   // 放下后左腿
-      break;
-    case 3:                  // 准备移动身体
-      showFace("surprised"); // 显示惊讶表情
-      // 稍作停顿，为下一步准备
-      break;
-    case 4: // 准备抬起前左腿和后右腿
-      setServo(FRONT_LEFT_LEG, centerPos - legLiftHeight); // 抬起前左腿
-      setServo(BACK_RIGHT_LEG, centerPos - legLiftHeight); // 抬起后右腿
-      break;
-    case 5:                                            // 前左腿和后右腿向前迈步
-      setServo(FRONT_LEFT_HIP, centerPos - amplitude); // 前左髋关节向前
-      setServo(BACK_RIGHT_HIP, centerPos + amplitude); // 后右髋关节向前
-      break;
-    case 6:                                // 放下前左腿和后右腿
-      setServo(FRONT_LEFT_LEG, centerPos); // 放下前左腿
-      setServo(BACK_RIGHT_LEG, centerPos); // 放下后右腿
-      break;
-    case 7: // 恢复所有髋关节到中心位置，准备下一个循环
-      setServo(FRONT_RIGHT_HIP, centerPos); // 前右髋关节回中
-      setServo(FRONT_LEFT_HIP, centerPos);  // 前左髋关节回中
-      setServo(BACK_RIGHT_HIP, centerPos);  // 后右髋关节回中
-      setServo(BACK_LEFT_HIP, centerPos);   // 后左髋关节回中
-      break;
-    }
+    walkStep(walkPhase, amplitude, legLiftHeight, currentMotionParams.steer, transform);
 
     // 增加计数器，进入下一阶段
     sharedCounter += 1;
 
     // 如果需要停止行走，可以在这里检查某个条件，然后设置状态为Completed
-    if (sharedCounter >= 64) { // 假设走64个阶段后停止
+    if (sharedCounter >= paramCycles(defaultCycles) * 8u) { // 走完指定周期后停止
       debuglnF("Robot completed walking.");
-      for (int i = 0; i < 8; i++) {
-        setServo(i, 90);
-      }
+      setAllServos(90);
       currentMotionState = RobotMotionState::Completed; // 设置为完成状态
       nextMotionId = RobotMotionId::Idle; // 完成后设置下一个动作为Idle
     }
@@ -155,60 +252,68 @@ public:
   void handleCompleted() override {
     // 完成状态的处理，如果需要的话
   }
+
+private:
+  const GaitTransform transform; // 向后走时倒放步态
 };
 
 class MotionHandler_AutoWalking : public MotionHandler {
 public:
-  MotionHandler_AutoWalking() { motionId = RobotMotionId::AutoWalking; }
-  
-  // 定义类成员变量
-  const uint8_t amplitude = 20;     // 髋关节运动幅度
-  const uint8_t legLiftHeight = 10; // 腿抬起高度
-  const uint8_t centerPos = 90;     // 中心位置
-  
+  void handleMotion() override {
+    // 测距与阶段解耦：后台按测距频率测距，读数通过 DistanceMeasured 事件送到 onDistance。
+    // 开始或恢复时也要请求，使第一个阶段之后就有读数
+    requestUSReadings();
+    MotionHandler::handleMotion();
+  }
+
+  // 测距事件的订阅者：行走时发现障碍，在测距的同一次循环内打断当前阶段，不等阶段结束
+  static void onDistance(const RobotEvent &event) {
+    if (currentMotionId != RobotMotionId::AutoWalking ||
+        currentMotionState != RobotMotionState::InProgress) {
+      return;
+    }
+    distance = event.value;
+    debugF("US Distance: ");
+    debugln(distance);
+    // 扫描后转向的第一次测距用来确认对准了空隙，前方不够空闲时重新扫描
+    bool aimMissed = checkAim && distance < SCAN_CLEAR_MM;
+    checkAim = false;
+    if (distance < AVOID_DISTANCE_MM || aimMissed) { // 如果距离小于400mm，转向或停止
+      avoidObstacle();
+      watchdogCheckin(WatchdogTask::Motion); // 已停下并转入避障动作
+    }
+  }
+
   void handleNotStarted() override {
     debuglnF("Robot starts auto walking.");
     debugF("Auto walking with amplitude: ");
-    debug(amplitude);
+    debug(paramAmplitude(defaultAmplitude));
     debuglnF(" degrees");
 
-    // 显示表情
-    showFace("happy"); // 显示高兴表情
-
     sharedCounter = 0;
     // 初始化所有舵机位置，准备行走
-    for (int i = 0; i < 8; i++) {
-      setServo(i, centerPos); // 所有舵机回到中心位置
-    }
-    currentMotionState = RobotMotionState::InProgress;
+    setAllServos(centerPos); // 所有舵机回到中心位置
+    startWalking();
+  }
+
+  void handleResume(uint16_t counter) override {
+    // 避障动作结束时四脚着地、关节回中。步态只写入与上一个关键帧不同的关节，
+    // 只有上一个关键帧也是回中姿态的阶段 0 能从这里进入（阶段 4 的上一帧中两个髋关节已经摆出，
+    // 不会再写入，会一直停在中心）。从被打断处之后最近的周期开始继续，不重新回中，已走的周期数也保留
+    debuglnF("Robot resumes auto walking.");
+    sharedCounter = (counter + walkGait.length - 1) / walkGait.length * walkGait.length;
+    cycleSteer = currentMotionParams.steer; // 从周期中间进入时，避障前的转向量已不适用
+    startWalking();
   }
   
   void handleInProgress() override {
-    // 获取超声波传感器数据
-    int distance = getUSDistance(); // 假设有一个函数获取距离
-
-    debugF("US Distance: ");
-    debugln(distance);
+    const uint8_t amplitude = paramAmplitude(defaultAmplitude);
+    const uint8_t legLiftHeight = paramLiftHeight(defaultLegLiftHeight);
 
-    if (distance < 400) { // 如果距离小于400mm，转向或停止
-      // 根据 sharedCounter 来决定转向的具体动作
-      if (sharedCounter % 2 == 0) {
-        showFace("confused"); // 显示困惑表情
-        debuglnF("Obstacle detected, turning left.");
-        currentMotionState = RobotMotionState::NotStarted; // 重置状态，准备转向
-        currentMotionId = RobotMotionId::TurningLeft;      // 设置为左转状态
-        // 直接跳转到对应的状态
-        // 设置下一个状态为回归 autoWalking
-        nextMotionId = RobotMotionId::AutoWalking; // 转向后继续自动行走
-      } else {
-        showFace("angry"); // 显示生气表情
-        debuglnF("Obstacle detected, turning right.");
-        setMovingState(RobotMotionId::TurningRight);
-        currentMotionState = RobotMotionState::NotStarted; // 重置状态，准备转向
-        currentMotionId = RobotMotionId::TurningRight;     // 设置为右转状态
-        nextMotionId = RobotMotionId::AutoWalking;         // 转向后继续自动行走
-      }
-      return;
+    // 障碍还不太近时边走边转，不需要停下
+    int8_t steer = getAvoidMode() == AvoidMode::Steer ? avoidSteer(distance) : 0;
+    if (steer == 0) {
+      steer = currentMotionParams.steer;
     }
 
     // 机器人行走循环
@@ -216,242 +321,127 @@ public:
 
     debugF("Walking phase: ");
     debugln(walkPhase);
+    publishEvent(RobotEventType::PhaseAdvanced,
+                 static_cast<uint8_t>(currentMotionId), walkPhase);
 
-    switch (walkPhase) {
-    case 0:                 // 准备抬起前右腿和后左腿
-      showFace("thinking"); // 显示思考表情
-      setServo(FRONT_RIGHT_LEG, centerPos - legLiftHeight); // 抬起前右腿
-      setServo(BACK_LEFT_LEG, centerPos - legLiftHeight);   // 抬起后左腿
-      break;
-    case 1: // 前右腿和后左腿向前迈步
-      setServo(FRONT_RIGHT_HIP, centerPos + amplitude); // 前右髋关节向前
-      setServo(BACK_LEFT_HIP, centerPos - amplitude);   // 后左髋关节向前
-      break;
-    case 2:                                 // 放下前右腿和后左腿
-      setServo(FRONT_RIGHT_LEG, centerPos); // 放下前右腿
-      setServo(BACK_LEFT_LEG, centerPos);   // 放下后左腿
-      break;
-    case 3:                  // 准备移动身体
-      showFace("surprised"); // 显示惊讶表情
-      // 稍作停顿，为下一步准备
-      break;
-    case 4: // 准备抬起前左腿和后右腿
-      setServo(FRONT_LEFT_LEG, centerPos - legLiftHeight); // 抬起前左腿
-      setServo(BACK_RIGHT_LEG, centerPos - legLiftHeight); // 抬起后右腿
-      break;
-    case 5:                                            // 前左腿和后右腿向前迈步
-      setServo(FRONT_LEFT_HIP, centerPos - amplitude); // 前左髋关节向前
-      setServo(BACK_RIGHT_HIP, centerPos + amplitude); // 后右髋关节向前
-      break;
-    case 6:                                // 放下前左腿和后右腿
-      setServo(FRONT_LEFT_LEG, centerPos); // 放下前左腿
-      setServo(BACK_RIGHT_LEG, centerPos); // 放下后右腿
-      break;
-    case 7: // 恢复所有髋关节到中心位置，准备下一个循环
-      setServo(FRONT_RIGHT_HIP, centerPos); // 前右髋关节回中
-      setServo(FRONT_LEFT_HIP, centerPos);  // 前左髋关节回中
-      setServo(BACK_RIGHT_HIP, centerPos);  // 后右髋关节回中
-      setServo(BACK_LEFT_HIP, centerPos);   // 后左髋关节回中
-      break;
-    }
+    walkStep(walkPhase, amplitude, legLiftHeight, steer);
     
     // 增加计数器
     sharedCounter++;
+
+    // 指定了循环次数时，走完后停止；默认一直走下去
+    if (currentMotionParams.cycles != 0 &&
+        sharedCounter >= currentMotionParams.cycles * 8u) {
+      currentMotionState = RobotMotionState::Completed;
+    }
   }
   
   void handleCompleted() override {
     // 如果当前状态已完成，可能需要重置或进入下一个动作
     debuglnF("Robot completed auto walking.");
-    for (int i = 0; i < 8; i++) {
-      setServo(i, 90); // 所有舵机回到中心位置
-    }
-    setMovingState(RobotMotionId::Idle); // 设置下一个动作为Idle
+    setAllServos(90); // 所有舵机回到中心位置
+    publishEvent(RobotEventType::MotionRequested, static_cast<uint8_t>(RobotMotionId::Idle),
+                 MOTION_REQUEST_SET); // 设置下一个动作为Idle
   }
-};
 
-class MotionHandler_TurningLeft : public MotionHandler {
-public:
-  MotionHandler_TurningLeft() { motionId = RobotMotionId::TurningLeft; }
-  
-  // 定义类成员变量
-  const uint8_t turnAmplitude = 20; // 转向幅度
-  const uint8_t legLiftHeight = 10; // 腿抬起高度
-  const uint8_t centerPos = 90;     // 中心位置
-  
-  void handleNotStarted() override {
-    debuglnF("Robot starts turning left.");
-    debugF("Turning left with amplitude: ");
-    debug(turnAmplitude);
-    debuglnF(" degrees");
+private:
+  static int distance;              // 最近一次测得的前方距离
+  static uint16_t walkStart;        // 本次开始或恢复行走时的计数器
+  static bool checkAim;             // 下一次测距要确认扫描后对准了空隙
 
-    sharedCounter = 0;
-    // 初始化所有舵机位置，准备转弯
-    for (int i = 0; i < 8; i++) {
-      setServo(i, centerPos); // 所有舵机回到中心位置
-    }
+  static void startWalking() {
+    walkStart = sharedCounter;
+    // 只处理开始行走之后的读数；测距暂停过，因此开始后的第一次循环就会测距
+    distance = STEER_DISTANCE_MM;
+    checkAim = takeScanAimCheck();
     currentMotionState = RobotMotionState::InProgress;
   }
-  
-  void handleInProgress() override {
-    // 机器人左转循环
-    uint8_t turnPhase = sharedCounter % 6; // 将左转分为6个阶段
-
-    debugF("Left turning phase: ");
-    debugln(turnPhase);
-
-    switch (turnPhase) {
-    case 0:                                                 // 准备抬起所有腿
-      setServo(FRONT_RIGHT_LEG, centerPos - legLiftHeight); // 抬起前右腿
-      setServo(FRONT_LEFT_LEG, centerPos - legLiftHeight);  // 抬起前左腿
-      setServo(BACK_RIGHT_LEG, centerPos - legLiftHeight);  // 抬起后右腿
-      setServo(BACK_LEFT_LEG, centerPos - legLiftHeight);   // 抬起后左腿
-      break;
-    case 1:                                                 // 所有髋关节向左转
-      setServo(FRONT_RIGHT_HIP, centerPos - turnAmplitude); // 前右髋关节左转
-      setServo(FRONT_LEFT_HIP, centerPos - turnAmplitude);  // 前左髋关节左转
-      setServo(BACK_RIGHT_HIP, centerPos - turnAmplitude);  // 后右髋关节左转
-      setServo(BACK_LEFT_HIP, centerPos - turnAmplitude);   // 后左髋关节左转
-      break;
-    case 2:                                 // 放下所有腿
-      setServo(FRONT_RIGHT_LEG, centerPos); // 放下前右腿
-      setServo(FRONT_LEFT_LEG, centerPos);  // 放下前左腿
-      setServo(BACK_RIGHT_LEG, centerPos);  // 放下后右腿
-      setServo(BACK_LEFT_LEG, centerPos);   // 放下后左腿
-      break;
-    case 3:                                                 // 再次抬起所有腿
-      setServo(FRONT_RIGHT_LEG, centerPos - legLiftHeight); // 抬起前右腿
-      setServo(FRONT_LEFT_LEG, centerPos - legLiftHeight);  // 抬起前左腿
-      setServo(BACK_RIGHT_LEG, centerPos - legLiftHeight);  // 抬起后右腿
-      setServo(BACK_LEFT_LEG, centerPos - legLiftHeight);   // 抬起后左腿
-      break;
-    case 4:                                 // 所有髋关节回到中心位置
-      setServo(FRONT_RIGHT_HIP, centerPos); // 前右髋关节回中
-      setServo(FRONT_LEFT_HIP, centerPos);  // 前左髋关节回中
-      setServo(BACK_RIGHT_HIP, centerPos);  // 后右髋关节回中
-      setServo(BACK_LEFT_HIP, centerPos);   // 后左髋关节回中
-      break;
-    case 5:                                 // 放下所有腿
-      setServo(FRONT_RIGHT_LEG, centerPos); // 放下前右腿
-      setServo(FRONT_LEFT_LEG, centerPos);  // 放下前左腿
-      setServo(BACK_RIGHT_LEG, centerPos);  // 放下后右腿
-      setServo(BACK_LEFT_LEG, centerPos);   // 放下后左腿
-
-      // 完成一个完整的转向周期后，增加计数器
-      sharedCounter += 1;
-
-      // 如果已经完成了足够的转向周期，则标记为完成
-      if (sharedCounter >= 12) { // 完成2个完整转向周期
-        currentMotionState = RobotMotionState::Completed;
-        debuglnF("Left turn completed.");
-      }
-      break;
-    }
 
-    // 如果没有到case 5，也增加计数器进入下一阶段
-    if (turnPhase != 5) {
-      sharedCounter += 1;
-    }
+  // 打断自动行走转入 motion，motion 完成后从打断处恢复。
+  // 直接调用动作引擎，不经过可能已满的事件缓冲区，避障请求不会丢失
+  static void requestAvoidance(RobotMotionId motion) {
+    suspendCurrentMotion(motion);
   }
-  
-  void handleCompleted() override {
-    // 转弯完成后的处理
-    debuglnF("Left turn state completed.");
 
-    // 如果有下一个动作ID设置，将自动切换到该状态
-    // 否则默认回到空闲状态
-    if (nextMotionId == currentMotionId) {
-      setMovingState(RobotMotionId::Idle);
+  // 立即停在四脚着地的姿态，再请求避障动作
+  static void avoidObstacle() {
+    // 反应延迟从障碍最早可能被测到的时间算起，到停止姿态的脉冲真正输出为止
+    awaitPoseEmission(usObservableMicros(), recordReactionLatency);
+    setAllServos(centerPos);
+    uint16_t walked = sharedCounter - walkStart;
+    noteAvoidance(walked, distance);
+
+    if (getAvoidMode() == AvoidMode::Scan) {
+      // 先扫描前方扇区，再转向最宽的空闲方向
+      publishEvent(RobotEventType::ObstacleDetected,
+                   static_cast<uint8_t>(RobotMotionId::Scanning), distance);
+      debuglnF("Obstacle detected, scanning.");
+      requestAvoidance(RobotMotionId::Scanning); // 扫描和转向后继续自动行走
+      return;
+    }
+    // 根据本次行走的阶段数来决定转向的具体动作，之后边走边转也沿用这一侧
+    noteTurnSide(walked % 2 == 0);
+    if (walked % 2 == 0) {
+      publishEvent(RobotEventType::ObstacleDetected,
+                   static_cast<uint8_t>(RobotMotionId::TurningLeft), distance);
+      debuglnF("Obstacle detected, turning left.");
+      requestAvoidance(RobotMotionId::TurningLeft); // 左转后继续自动行走
+    } else {
+      publishEvent(RobotEventType::ObstacleDetected,
+                   static_cast<uint8_t>(RobotMotionId::TurningRight), distance);
+      debuglnF("Obstacle detected, turning right.");
+      requestAvoidance(RobotMotionId::TurningRight); // 右转后继续自动行走
     }
   }
 };
 
-class MotionHandler_TurningRight : public MotionHandler {
+int MotionHandler_AutoWalking::distance = STEER_DISTANCE_MM;
+uint16_t MotionHandler_AutoWalking::walkStart = 0;
+bool MotionHandler_AutoWalking::checkAim = false;
+
+// 转向：左转和右转共用一个步态，右转是左转的镜像
+class MotionHandler_Turning : public MotionScriptHandler {
 public:
-  MotionHandler_TurningRight() { motionId = RobotMotionId::TurningRight; }
-  
-  // 定义类成员变量
-  const uint8_t turnAmplitude = 20; // 转向幅度
-  const uint8_t legLiftHeight = 10; // 腿抬起高度
-  const uint8_t centerPos = 90;     // 中心位置
-  
-  void handleNotStarted() override {
-    debuglnF("Robot starts turning right.");
-    debugF("Turning right with amplitude: ");
-    debug(turnAmplitude);
+  static constexpr uint8_t defaultCycles = 2; // 默认转向周期数
+
+  explicit MotionHandler_Turning(bool left) : left(left) {}
+
+  bool runScript() override {
+    MOTION_SCRIPT_BEGIN();
+    if (left) {
+      debuglnF("Robot starts turning left.");
+    } else {
+      debuglnF("Robot starts turning right.");
+    }
+    debugF("Turning with amplitude: ");
+    debug(paramAmplitude(defaultAmplitude));
     debuglnF(" degrees");
 
-    sharedCounter = 0;
+    planTurn(left, defaultCycles);
     // 初始化所有舵机位置，准备转弯
-    for (int i = 0; i < 8; i++) {
-      setServo(i, centerPos); // 所有舵机回到中心位置
-    }
-    currentMotionState = RobotMotionState::InProgress;
-  }
-  
-  void handleInProgress() override {
-    // 机器人右转循环
-    uint8_t turnPhase = sharedCounter % 6; // 将右转分为6个阶段
-
-    debugF("Right turning phase: ");
-    debugln(turnPhase);
-
-    switch (turnPhase) {
-    case 0:                                                 // 准备抬起所有腿
-      setServo(FRONT_RIGHT_LEG, centerPos - legLiftHeight); // 抬起前右腿
-      setServo(FRONT_LEFT_LEG, centerPos - legLiftHeight);  // 抬起前左腿
-      setServo(BACK_RIGHT_LEG, centerPos - legLiftHeight);  // 抬起后右腿
-      setServo(BACK_LEFT_LEG, centerPos - legLiftHeight);   // 抬起后左腿
-      break;
-    case 1:                                                 // 所有髋关节向右转
-      setServo(FRONT_RIGHT_HIP, centerPos + turnAmplitude); // 前右髋关节右转
-      setServo(FRONT_LEFT_HIP, centerPos + turnAmplitude);  // 前左髋关节右转
-      setServo(BACK_RIGHT_HIP, centerPos + turnAmplitude);  // 后右髋关节右转
-      setServo(BACK_LEFT_HIP, centerPos + turnAmplitude);   // 后左髋关节右转
-      break;
-    case 2:                                 // 放下所有腿
-      setServo(FRONT_RIGHT_LEG, centerPos); // 放下前右腿
-      setServo(FRONT_LEFT_LEG, centerPos);  // 放下前左腿
-      setServo(BACK_RIGHT_LEG, centerPos);  // 放下后右腿
-      setServo(BACK_LEFT_LEG, centerPos);   // 放下后左腿
-      break;
-    case 3:                                                 // 再次抬起所有腿
-      setServo(FRONT_RIGHT_LEG, centerPos - legLiftHeight); // 抬起前右腿
-      setServo(FRONT_LEFT_LEG, centerPos - legLiftHeight);  // 抬起前左腿
-      setServo(BACK_RIGHT_LEG, centerPos - legLiftHeight);  // 抬起后右腿
-      setServo(BACK_LEFT_LEG, centerPos - legLiftHeight);   // 抬起后左腿
-      break;
-    case 4:                                 // 所有髋关节回到中心位置
-      setServo(FRONT_RIGHT_HIP, centerPos); // 前右髋关节回中
-      setServo(FRONT_LEFT_HIP, centerPos);  // 前左髋关节回中
-      setServo(BACK_RIGHT_HIP, centerPos);  // 后右髋关节回中
-      setServo(BACK_LEFT_HIP, centerPos);   // 后左髋关节回中
-      break;
-    case 5:                                 // 放下所有腿
-      setServo(FRONT_RIGHT_LEG, centerPos); // 放下前右腿
-      setServo(FRONT_LEFT_LEG, centerPos);  // 放下前左腿
-      setServo(BACK_RIGHT_LEG, centerPos);  // 放下后右腿
-      setServo(BACK_LEFT_LEG, centerPos);   // 放下后左腿
-
-      // 完成一个完整的转向周期后，增加计数器
-      sharedCounter += 1;
-
-      // 如果已经完成了足够的转向周期，则标记为完成
-      if (sharedCounter >= 12) { // 完成2个完整转向周期
-        currentMotionState = RobotMotionState::Completed;
-        debuglnF("Right turn completed.");
+    setAllServos(centerPos); // 所有舵机回到中心位置
+
+    // 完成规划的转向周期，最后一个周期的幅度可能较小
+    for (cycle = 0; cycle < turnPlanCycles; cycle++) {
+      for (phase = 0; phase < turnGait.length; phase++) {
+        MOTION_NEXT_PHASE();
+        debugF("Turning phase: ");
+        debugln(phase);
+        publishEvent(RobotEventType::PhaseAdvanced,
+                     static_cast<uint8_t>(currentMotionId), phase);
+
+        const uint8_t turnAmplitude = turnCycleAmplitude(cycle);
+        applyGaitPhase(turnGait, left ? GAIT_IDENTITY : GAIT_MIRROR, phase, turnAmplitude,
+                       turnAmplitude, paramLiftHeight(defaultLegLiftHeight));
       }
-      break;
-    }
-
-    // 如果没有到case 5，也增加计数器进入下一阶段
-    if (turnPhase != 5) {
-      sharedCounter += 1;
     }
+    debuglnF("Turn completed.");
+    MOTION_SCRIPT_END();
   }
-  
+
   void handleCompleted() override {
     // 转弯完成后的处理
-    debuglnF("Right turn state completed.");
+    debuglnF("Turn state completed.");
 
     // 如果有下一个动作ID设置，将自动切换到该状态
     // 否则默认回到空闲状态
@@ -459,124 +449,44 @@ public:
       setMovingState(RobotMotionId::Idle);
     }
   }
+
+private:
+  const bool left; // 左转；右转时使用镜像的步态
+  uint16_t cycle;  // 当前转向周期
+  uint8_t phase;   // 周期内的阶段
 };
 
-class MotionHandler_Dancing : public MotionHandler {
+class MotionHandler_Dancing : public MotionScriptHandler {
 public:
-  MotionHandler_Dancing() { motionId = RobotMotionId::Dancing; }
-  
-  // 定义类成员变量
-  const uint8_t hipSwingAmplitude = 30; // 髋关节摆动幅度
-  const uint8_t legLiftHeight = 20;     // 腿抬起高度
-  const uint8_t centerPos = 90;         // 中心位置
-  
-  void handleNotStarted() override {
+  // 舞蹈动作幅度更大，覆盖基类的默认抬腿高度
+  static constexpr uint8_t defaultHipSwingAmplitude = 30; // 默认髋关节摆动幅度
+  static constexpr uint8_t defaultLegLiftHeight = 20;     // 默认腿抬起高度
+  static constexpr uint8_t defaultCycles = 3;             // 默认舞蹈循环次数
+  static_assert(defaultHipSwingAmplitude <= MOTION_AMPLITUDE_MAX &&
+                    defaultLegLiftHeight <= MOTION_LIFT_HEIGHT_MAX,
+                "default dance parameters exceed the limits");
+
+  bool runScript() override {
+    MOTION_SCRIPT_BEGIN();
     debuglnF("Robot starts dancing.");
-    sharedCounter = 0;
     // 初始化所有舵机位置，准备跳舞
-    for (int i = 0; i < 8; i++) {
-      setServo(i, centerPos); // 所有舵机回到中心位置
-    }
-    currentMotionState = RobotMotionState::InProgress;
-  }
-  
-  void handleInProgress() override {
-    // 机器人跳舞循环
-    uint8_t dancePhase = sharedCounter % 12; // 将舞蹈分为12个阶段
-
-    debugF("Dancing phase: ");
-    debugln(dancePhase);
-
-    switch (dancePhase) {
-    case 0:                // 准备姿势 - 稍微抬起所有腿
-      showFace("excited"); // 显示兴奋表情
-      setServo(FRONT_RIGHT_LEG, centerPos - legLiftHeight / 2);
-      setServo(FRONT_LEFT_LEG, centerPos - legLiftHeight / 2);
-      setServo(BACK_RIGHT_LEG, centerPos - legLiftHeight / 2);
-      setServo(BACK_LEFT_LEG, centerPos - legLiftHeight / 2);
-      break;
-    case 1: // 前腿下压，后腿抬起
-      setServo(FRONT_RIGHT_LEG, centerPos);
-      setServo(FRONT_LEFT_LEG, centerPos);
-      setServo(BACK_RIGHT_LEG, centerPos - legLiftHeight);
-      setServo(BACK_LEFT_LEG, centerPos - legLiftHeight);
-      break;
-    case 2: // 髋关节左右摆动
-      setServo(FRONT_RIGHT_HIP, centerPos + hipSwingAmplitude);
-      setServo(FRONT_LEFT_HIP, centerPos - hipSwingAmplitude);
-      setServo(BACK_RIGHT_HIP, centerPos + hipSwingAmplitude);
-      setServo(BACK_LEFT_HIP, centerPos - hipSwingAmplitude);
-      break;
-    case 3: // 髋关节反向摆动
-      setServo(FRONT_RIGHT_HIP, centerPos - hipSwingAmplitude);
-      setServo(FRONT_LEFT_HIP, centerPos + hipSwingAmplitude);
-      setServo(BACK_RIGHT_HIP, centerPos - hipSwingAmplitude);
-      setServo(BACK_LEFT_HIP, centerPos + hipSwingAmplitude);
-      break;
-    case 4: // 前腿抬起，后腿下压
-      setServo(FRONT_RIGHT_LEG, centerPos - legLiftHeight);
-      setServo(FRONT_LEFT_LEG, centerPos - legLiftHeight);
-      setServo(BACK_RIGHT_LEG, centerPos);
-      setServo(BACK_LEFT_LEG, centerPos);
-      break;
-    case 5: // 对角线动作 - 前右和后左抬高
-      setServo(FRONT_RIGHT_LEG, centerPos - legLiftHeight);
-      setServo(BACK_LEFT_LEG, centerPos - legLiftHeight);
-      setServo(FRONT_LEFT_LEG, centerPos);
-      setServo(BACK_RIGHT_LEG, centerPos);
-      break;
-    case 6:             // 对角线动作 - 前左和后右抬高
-      showFace("love"); // 显示爱心表情
-      setServo(FRONT_LEFT_LEG, centerPos - legLiftHeight);
-      setServo(BACK_RIGHT_LEG, centerPos - legLiftHeight);
-      setServo(FRONT_RIGHT_LEG, centerPos);
-      setServo(BACK_LEFT_LEG, centerPos);
-      break;
-    case 7: // 全身"抖动" - 所有髋关节左转
-      setServo(FRONT_RIGHT_HIP, centerPos - hipSwingAmplitude / 2);
-      setServo(FRONT_LEFT_HIP, centerPos - hipSwingAmplitude / 2);
-      setServo(BACK_RIGHT_HIP, centerPos - hipSwingAmplitude / 2);
-      setServo(BACK_LEFT_HIP, centerPos - hipSwingAmplitude / 2);
-      break;
-    case 8: // 全身"抖动" - 所有髋关节右转
-      setServo(FRONT_RIGHT_HIP, centerPos + hipSwingAmplitude / 2);
-      setServo(FRONT_LEFT_HIP, centerPos + hipSwingAmplitude / 2);
-      setServo(BACK_RIGHT_HIP, centerPos + hipSwingAmplitude / 2);
-      setServo(BACK_LEFT_HIP, centerPos + hipSwingAmplitude / 2);
-      break;
-    case 9: // 再次全身"抖动" - 所有髋关节左转
-      setServo(FRONT_RIGHT_HIP, centerPos - hipSwingAmplitude / 2);
-      setServo(FRONT_LEFT_HIP, centerPos - hipSwingAmplitude / 2);
-      setServo(BACK_RIGHT_HIP, centerPos - hipSwingAmplitude / 2);
-      setServo(BACK_LEFT_HIP, centerPos - hipSwingAmplitude / 2);
-      break;
-    case 10: // 结束动作 - 髋关节回中
-      setServo(FRONT_RIGHT_HIP, centerPos);
-      setServo(FRONT_LEFT_HIP, centerPos);
-      setServo(BACK_RIGHT_HIP, centerPos);
-      setServo(BACK_LEFT_HIP, centerPos);
-      break;
-    case 11: // 结束动作 - 腿部回中
-      setServo(FRONT_RIGHT_LEG, centerPos);
-      setServo(FRONT_LEFT_LEG, centerPos);
-      setServo(BACK_RIGHT_LEG, centerPos);
-      setServo(BACK_LEFT_LEG, centerPos);
-
-      // 增加计数器，用于确定是否完成舞蹈
-      sharedCounter += 1;
-
-      // 如果完成了3个完整的舞蹈循环，则标记为完成
-      if (sharedCounter >= 36) { // 3 * 12 = 36
-        currentMotionState = RobotMotionState::Completed;
-        debuglnF("Dancing completed.");
+    setAllServos(centerPos); // 所有舵机回到中心位置
+
+    for (cycle = 0; cycle < paramCycles(defaultCycles); cycle++) {
+      for (phase = 0; phase < danceGait.length; phase++) {
+        MOTION_NEXT_PHASE();
+        debugF("Dancing phase: ");
+        debugln(phase);
+        publishEvent(RobotEventType::PhaseAdvanced,
+                     static_cast<uint8_t>(RobotMotionId::Dancing), phase);
+
+        const uint8_t hipSwingAmplitude = paramAmplitude(defaultHipSwingAmplitude);
+        applyGaitPhase(danceGait, GAIT_IDENTITY, phase, hipSwingAmplitude, hipSwingAmplitude,
+                       paramLiftHeight(defaultLegLiftHeight));
       }
-      break;
-    }
-
-    // 如果不是最后一个阶段，增加计数器
-    if (dancePhase != 11) {
-      sharedCounter += 1;
     }
+    debuglnF("Dancing completed.");
+    MOTION_SCRIPT_END();
   }
   
   void handleCompleted() override {
@@ -584,35 +494,33 @@ public:
     debuglnF("Dance completed, returning to idle.");
 
     // 确保所有舵机回到中心位置
-    for (int i = 0; i < 8; i++) {
-      setServo(i, 90);
-    }
+    setAllServos(90);
 
     // 如果没有设置下一个状态，则默认回到空闲状态
     if (nextMotionId == currentMotionId) {
       setMovingState(RobotMotionId::Idle);
     }
   }
+
+private:
+  uint8_t cycle; // 当前舞蹈循环
+  uint8_t phase; // 循环内的阶段
 };
-class MotionHandler_Singing : public MotionHandler {
+class MotionHandler_Singing : public MotionScriptHandler {
 public:
-  MotionHandler_Singing() { motionId = RobotMotionId::Singing; }
-  
-  void handleNotStarted() override {
+  static_assert(MOTION_SING_NOTE_MS < WATCHDOG_DEFAULT_DEADLINE_MS,
+                "a note must not starve the watchdog");
+
+  bool runScript() override {
+    MOTION_SCRIPT_BEGIN();
     debuglnF("Robot starts singing.");
-    sharedCounter = 0;
-    currentMotionState = RobotMotionState::InProgress;
-  }
-  
-  void handleInProgress() override {
-    // 这里可以添加具体的唱歌动作逻辑
-    debuglnF("Robot is singing...");
-    
-    // 模拟唱歌结束
-    sharedCounter++;
-    if (sharedCounter >= 10) {
-      currentMotionState = RobotMotionState::Completed;
+    // 这里可以添加具体的唱歌动作逻辑，模拟按节拍唱完每个音符后结束
+    while (sharedCounter < MOTION_SING_NOTES) {
+      debuglnF("Robot is singing...");
+      MOTION_WAIT_MS(MOTION_SING_NOTE_MS);
+      sharedCounter++; // 每个音符算一个阶段，同一个等待点上的下一个音符也向看门狗报到
     }
+    MOTION_SCRIPT_END();
   }
   
   void handleCompleted() override {
@@ -626,18 +534,20 @@ public:
 };
 class MotionHandler_DebugUS : public MotionHandler {
 public:
-  MotionHandler_DebugUS() { motionId = RobotMotionId::DebugUS; }
-  
   void handleNotStarted() override {
     debuglnF("Robot starts debugging US sensor.");
     currentMotionState = RobotMotionState::InProgress; // 设置为进行中状态
   }
   
   void handleInProgress() override {
-    // 获取超声波传感器数据
-    int distance = getUSDistance(); // 假设有一个函数获取距离
-    debugF("US Distance: ");
-    debugln(distance);
+    // 按测距频率输出最新的超声波读数
+    requestUSReadings();
+    const USReading &reading = latestUSReading();
+    if (reading.sequence != seenReading) {
+      seenReading = reading.sequence;
+      debugF("US Distance: ");
+      debugln(reading.distance);
+    }
 
     // 不阻断新的动作
     if (haveNextMotion()) {
@@ -648,26 +558,194 @@ public:
   void handleCompleted() override {
     debuglnF("Debugging US sensor completed.");
   }
+
+private:
+  uint8_t seenReading = 0; // 已经输出过的测距读数序号
+};
+
+class MotionHandler_Playback : public MotionHandler {
+public:
+  void handleMotion() override {
+    // 按片段中记录的时间回放，不等待舵机到位
+    if (currentMotionState == RobotMotionState::InProgress) {
+      handleInProgress();
+      watchdogCheckin(WatchdogTask::Motion); // 回放按时钟推进了片段
+      return;
+    }
+    MotionHandler::handleMotion();
+  }
+
+  void handleNotStarted() override {
+    debuglnF("Robot starts clip playback.");
+    sharedCounter = 0;
+    if (!beginClipPlayback()) {
+      debuglnF("Uploaded clip is longer than the buffer, cannot replay it.");
+      currentMotionState = RobotMotionState::Completed;
+      return;
+    }
+    currentMotionState = RobotMotionState::InProgress;
+  }
+
+  void handleInProgress() override {
+    // 同一时刻的目标在同一帧内一起生效
+    beginServoPose();
+    bool playing = updateClipPlayback();
+    commitServoPose();
+    if (playing) {
+      return;
+    }
+    // 一遍回放结束，按周期数重复（上传的长片段不能重复），有新的动作时立即结束
+    sharedCounter++;
+    if (sharedCounter < paramCycles(defaultCycles) && !haveNextMotion() &&
+        beginClipPlayback()) {
+      return;
+    }
+    currentMotionState = RobotMotionState::Completed;
+  }
+
+  void handleCompleted() override {
+    debuglnF("Clip playback completed.");
+
+    // 如果没有设置下一个状态，则默认回到空闲状态
+    if (nextMotionId == currentMotionId) {
+      setMovingState(RobotMotionId::Idle);
+    }
+  }
+
+private:
+  static constexpr uint8_t defaultCycles = 1;
 };
 
-MotionHandler *motionHandlers[] = {
-    new MotionHandler_Idle(),
-    new MotionHandler_Walking(),
-    new MotionHandler_AutoWalking(),
-    new MotionHandler_TurningLeft(),
-    new MotionHandler_TurningRight(),
-    new MotionHandler_Dancing(),
-    new MotionHandler_Singing(),
-    new MotionHandler_DebugUS(),
-    nullptr // 结束标志
+class MotionHandler_Scanning : public MotionScriptHandler {
+public:
+  void handleMotion() override {
+    // 扫描期间后台测距，每个方向使用舵机到位之后的读数
+    if (currentMotionState == RobotMotionState::InProgress) {
+      requestUSReadings();
+    }
+    MotionScriptHandler::handleMotion();
+  }
+
+  bool runScript() override {
+    MOTION_SCRIPT_BEGIN();
+    debuglnF("Robot starts scanning.");
+    beginScan();
+    // 四脚着地，髋关节转到第一个方向
+    setHips(scanBinAngle(scanBinAt(0)));
+    requestUSReadings();
+
+    // 第 n 个阶段（sharedCounter 为 n + 1）测量第 n 次的方向，然后转到下一个方向
+    while (scanBinAt(sharedCounter) < SCAN_BINS) {
+      MOTION_NEXT_PHASE();
+      // 到位之前开始的测距可能还朝着上一个方向，等待到位之后的一次新读数
+      MOTION_WAIT_EVENT(DistanceMeasured);
+      publishEvent(RobotEventType::PhaseAdvanced,
+                   static_cast<uint8_t>(currentMotionId), sharedCounter - 1);
+      recordScan(scanBinAt(sharedCounter - 1), latestUSReading().distance);
+      setHips(scanBinAt(sharedCounter) < SCAN_BINS ? scanBinAngle(scanBinAt(sharedCounter)) : 0);
+    }
+
+    // 扫描完成，等待身体回正
+    MOTION_NEXT_PHASE();
+    publishEvent(RobotEventType::PhaseAdvanced,
+                 static_cast<uint8_t>(currentMotionId), sharedCounter - 1);
+    if (decide()) {
+      // 请求转向替换扫描，转向完成后动作引擎恢复被打断的自动行走；缓冲区已满时下次循环重试
+      MOTION_WAIT_UNTIL(requestTurn());
+      // 动作引擎分发请求时切换到转向，之后不再运行扫描
+      MOTION_WAIT_UNTIL(currentMotionId != RobotMotionId::Scanning);
+    }
+    MOTION_SCRIPT_END();
+  }
+
+  void handleCompleted() override {
+    debuglnF("Scanning completed.");
+    if (nextMotionId == currentMotionId) {
+      setMovingState(RobotMotionId::Idle);
+    }
+  }
+
+private:
+  RobotMotionId turn;  // 扫描后选择的转向
+  uint8_t turnDegrees; // 需要转过的角度
+
+  // 按扫描结果选择方向，需要转向时返回 true
+  bool decide() {
+    ScanDecision decision = chooseScanBearing();
+    if (haveNextMotion() && nextMotionId != RobotMotionId::AutoWalking) {
+      return false; // 扫描期间收到了新的动作指令
+    }
+    if (decision.degrees == 0) {
+      debuglnF("Path ahead is clear.");
+      return false;
+    }
+    turn = decision.bearing > 0 ? RobotMotionId::TurningLeft : RobotMotionId::TurningRight;
+    turnDegrees = decision.degrees;
+    publishEvent(RobotEventType::ObstacleDetected, static_cast<uint8_t>(turn),
+                 decision.distance);
+    debugF("Turning towards bearing: ");
+    debugln(decision.bearing);
+    return true;
+  }
+
+  // 转向沿用速度和幅度，按标定表转过所选方向的角度
+  bool requestTurn() {
+    return publishEvent(RobotEventType::MotionRequested, static_cast<uint8_t>(turn),
+                        MOTION_REQUEST_VALUE(MOTION_REQUEST_REPLACE, turnDegrees));
+  }
+
+  // 四脚着地时髋关节向顺时针转，身体相对地面向逆时针（向左）转，反之亦然。
+  // 其余关节保持在中心位置，整个姿态在同一帧内一起生效
+  static void setHips(int8_t bearing) {
+    beginServoPose();
+    for (uint8_t leg = 0; leg < ROBOT_LEGS; leg++) {
+      for (uint8_t joint = 0; joint < BodyLayout::jointsPerLeg; joint++) {
+        setServo(BodyLayout::servo(leg, joint), joint == 0 ? centerPos - bearing : centerPos);
+      }
+    }
+    commitServoPose();
+  }
+};
+
+// 静态分配的动作处理器，避免在静态初始化阶段使用堆内存
+static MotionHandler_Idle idleHandler;
+static MotionHandler_Walking walkingHandler(GAIT_IDENTITY);
+static MotionHandler_Walking walkingBackwardHandler(GAIT_REVERSE);
+static MotionHandler_AutoWalking autoWalkingHandler;
+static MotionHandler_Turning turningLeftHandler(true);
+static MotionHandler_Turning turningRightHandler(false);
+static MotionHandler_Dancing dancingHandler;
+static MotionHandler_Singing singingHandler;
+static MotionHandler_DebugUS debugUSHandler;
+static MotionHandler_Playback playbackHandler;
+static MotionHandler_Scanning scanningHandler;
+
+// 动作处理器表，存放在 flash 中，必须按 RobotMotionId 的顺序排列
+MotionHandler *const motionHandlers[] PROGMEM = {
+    &idleHandler,         // Idle
+    &walkingHandler,      // Walking
+    &autoWalkingHandler,  // AutoWalking
+    &turningLeftHandler,  // TurningLeft
+    &turningRightHandler, // TurningRight
+    &dancingHandler,      // Dancing
+    &singingHandler,      // Singing
+    &debugUSHandler,      // DebugUS
+    &playbackHandler,     // Playback
+    &scanningHandler,     // Scanning
+    &walkingBackwardHandler, // WalkingBackward
 };
+static_assert(sizeof(motionHandlers) / sizeof(motionHandlers[0]) ==
+                  static_cast<uint8_t>(RobotMotionId::Count),
+              "motionHandlers must cover every RobotMotionId");
 
 void UpdateMotion() {
-  for (int i = 0; motionHandlers[i] != nullptr; i++) {
-    if (motionHandlers[i]->motionId == currentMotionId) {
-      motionHandlers[i]->handleMotion(); // 调用对应的处理函数
-      return;                            // 找到后直接返回
-    }
+  uint8_t index = static_cast<uint8_t>(currentMotionId);
+  if (index < static_cast<uint8_t>(RobotMotionId::Count)) {
+    // 直接按动作ID索引处理器，无需逐个查找
+    MotionHandler *handler =
+        static_cast<MotionHandler *>(pgm_read_ptr(&motionHandlers[index]));
+    handler->handleMotion(); // 调用对应的处理函数
+    return;
   }
 
   // 如果没有找到对应的处理器，可以添加错误处理逻辑
@@ -693,17 +771,233 @@ void MotionHandler::handleCompleted() {
   // 默认实现为空
 }
 
+void MotionHandler::handleResume(uint16_t counter) {
+  // 默认不支持恢复，重新开始动作
+  (void)counter;
+  handleNotStarted();
+}
+
+unsigned long MotionScriptHandler::scriptWaitStart = 0;
+
+void MotionScriptHandler::handleMotion() {
+  if (currentMotionState == RobotMotionState::InProgress) {
+    const uint16_t line = scriptLine;
+    const uint16_t counter = sharedCounter;
+    // 脚本可以在结束时直接切换到下一个动作，这时不再标记为完成
+    if (runScript() && currentMotionState == RobotMotionState::InProgress) {
+      currentMotionState = RobotMotionState::Completed;
+    }
+    // 脚本完成、进入下一阶段或到达新的等待点时才算有进展，停在同一个等待点上不算
+    if (scriptLine != line || sharedCounter != counter ||
+        currentMotionState != RobotMotionState::InProgress) {
+      watchdogCheckin(WatchdogTask::Motion);
+    }
+    return;
+  }
+  MotionHandler::handleMotion();
+}
+
+void MotionScriptHandler::handleNotStarted() {
+  sharedCounter = 0;
+  scriptLine = 0;
+  currentMotionState = RobotMotionState::InProgress;
+  // 第一个等待点之前的准备步骤（如舵机回中）在开始的这次循环中执行
+  if (runScript() && currentMotionState == RobotMotionState::InProgress) {
+    currentMotionState = RobotMotionState::Completed;
+  }
+}
+
+// 打断当前动作，立即转入 motion；motion 完成后当前动作从打断处恢复（见 handleResume）
+static void suspendCurrentMotion(RobotMotionId motion) {
+  suspendedMotionId = currentMotionId;
+  suspendedCounter = sharedCounter;
+  currentMotionState = RobotMotionState::NotStarted;
+  currentMotionId = motion;
+  nextMotionId = suspendedMotionId;
+  // 打断的动作沿用速度和幅度，但使用自身的默认周期数；
+  // 恢复被打断的动作时会从 nextMotionParams 恢复原参数
+  currentMotionParams.cycles = 0;
+}
+
+// 用 motion 替换当前动作，被打断的动作和下一个动作不变，motion 完成后照常切换或恢复
+static void replaceCurrentMotion(RobotMotionId motion, uint8_t degrees) {
+  if (nextMotionId == currentMotionId) {
+    nextMotionId = motion; // 没有下一个动作时，motion 完成后回到空闲
+  }
+  currentMotionId = motion;
+  currentMotionState = RobotMotionState::NotStarted;
+  // 沿用速度和幅度，使用自身的默认周期数，转向时按请求转过指定的角度
+  currentMotionParams.cycles = 0;
+  currentMotionParams.degrees = degrees;
+}
+
+// 动作请求的订阅者，动作只发布请求，由这里修改动作状态
+static void handleMotionRequest(const RobotEvent &event) {
+  const RobotMotionId motion = static_cast<RobotMotionId>(event.arg);
+  if (motion >= RobotMotionId::Count) {
+    return;
+  }
+  switch (event.value & 0xFF) {
+  case MOTION_REQUEST_SUSPEND:
+    suspendCurrentMotion(motion);
+    break;
+  case MOTION_REQUEST_REPLACE:
+    replaceCurrentMotion(motion, event.value >> 8);
+    break;
+  default:
+    setMovingState(motion);
+    break;
+  }
+}
+
+void setupMotionEvents() {
+  // 先于表情和日志处理，避障请求在发现障碍的同一次循环内生效
+  subscribeEvents(EVENT_MASK(MotionRequested), 0, handleMotionRequest);
+  subscribeEvents(EVENT_MASK(DistanceMeasured), 0, MotionHandler_AutoWalking::onDistance);
+}
+
+uint8_t MotionHandler::paramAmplitude(uint8_t fallback) {
+  return currentMotionParams.amplitude ? currentMotionParams.amplitude
+                                       : fallback;
+}
+
+uint8_t MotionHandler::paramLiftHeight(uint8_t fallback) {
+  return currentMotionParams.liftHeight ? currentMotionParams.liftHeight
+                                        : fallback;
+}
+
+uint8_t MotionHandler::paramCycles(uint8_t fallback) {
+  return currentMotionParams.cycles ? currentMotionParams.cycles : fallback;
+}
+
+void MotionHandler::walkStep(uint8_t phase, uint8_t amplitude, uint8_t liftHeight,
+                             int8_t steer, GaitTransform transform) {
+  // 每个周期开始时确定转向量，周期内两侧的步幅保持一致
+  if (phase == 0) {
+    cycleSteer = steer;
+  }
+  // 转向时右侧步幅加大、左侧减小（或相反），身体在前进的同时持续转向；
+  // 向后走时步幅大的一侧后退得更多，转向量取反，正值仍然向左
+  int delta = static_cast<int>(amplitude) * cycleSteer / MOTION_STEER_MAX;
+  if (transform & GAIT_REVERSE) {
+    delta = -delta;
+  }
+  const uint8_t right = constrain(amplitude + delta, 0, MOTION_AMPLITUDE_MAX);
+  const uint8_t left = constrain(amplitude - delta, 0, MOTION_AMPLITUDE_MAX);
+
+  applyGaitPhase(walkGait, transform, phase, right, left, liftHeight);
+}
+
+int8_t currentWalkSteer() { return cycleSteer; }
+
+// 幅度为 amplitude 时每个转向周期转过的角度（0.5 度），在标定点之间线性插值，
+// 幅度为 0 时不转，超出最后一个标定点时按最后两个点外推
+static uint16_t turnRate(bool left, uint8_t amplitude) {
+  const uint8_t step = IRobot::ServoTrim::TURN_AMPLITUDE_STEP;
+  uint8_t point = amplitude / step;
+  if (point >= IRobot::ServoTrim::TURN_POINTS) {
+    point = IRobot::ServoTrim::TURN_POINTS - 1;
+  }
+  int lower = point == 0 ? 0 : trimLoader.getTurn(left, point - 1);
+  int upper = trimLoader.getTurn(left, point);
+  long rate = lower + static_cast<long>(upper - lower) * (amplitude - point * step) / step;
+  return rate > 0 ? static_cast<uint16_t>(rate) : 0;
+}
+
+void MotionHandler::planTurn(bool left, uint8_t defaultCycles) {
+  turnPlanAmplitude = paramAmplitude(defaultAmplitude);
+  turnPlanLastAmplitude = turnPlanAmplitude;
+  turnPlanCycles = paramCycles(defaultCycles);
+  const uint16_t rate = turnRate(left, turnPlanAmplitude);
+  if (currentMotionParams.degrees == 0 || rate == 0) {
+    return;
+  }
+
+  // 按标定表换算：先走完整的周期，余下的角度用一个幅度较小的周期补上，不多转
+  const uint16_t target = currentMotionParams.degrees * 2u;
+  turnPlanCycles = target / rate;
+  uint16_t rest = target - turnPlanCycles * rate;
+  if (rest == 0) {
+    return;
+  }
+  uint8_t low = 0, high = turnPlanAmplitude; // 找出转过 rest 的最小幅度
+  while (low < high) {
+    uint8_t mid = (low + high) / 2;
+    if (turnRate(left, mid) < rest) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  turnPlanLastAmplitude = low;
+  turnPlanCycles++;
+  debugF("Turn cycles planned: ");
+  debugln(turnPlanCycles);
+}
+
+uint8_t MotionHandler::turnCycleAmplitude(uint16_t cycle) {
+  return cycle + 1 >= turnPlanCycles ? turnPlanLastAmplitude : turnPlanAmplitude;
+}
+
+uint8_t currentTurnAmplitude() {
+  if (currentMotionId != RobotMotionId::TurningLeft &&
+      currentMotionId != RobotMotionId::TurningRight) {
+    return 0;
+  }
+  // 阶段执行后计数器已前进，上一个阶段所在的周期
+  uint16_t cycle = sharedCounter == 0 ? 0 : (sharedCounter - 1) / turnGait.length;
+  return cycle + 1 >= turnPlanCycles ? turnPlanLastAmplitude : turnPlanAmplitude;
+}
+
+bool MotionHandler::phaseDue() {
+  static unsigned long lastPhaseTime = 0; // 上一阶段开始的时间
+  unsigned long now = tickMillis();
+  unsigned long elapsed = now - lastPhaseTime;
+
+  // 等待上一阶段的舵机实际转动到位，超时后不再等待
+  if (!servosSettled() && elapsed < SERVO_SETTLE_TIMEOUT_MS) {
+    return false;
+  }
+
+  // 速度低于全速时，阶段之间额外等待
+  uint8_t speed = currentMotionParams.speed;
+  if (speed != 0 && speed < MOTION_SPEED_MAX) {
+    unsigned long interval = static_cast<unsigned long>(MOTION_SPEED_MAX - speed) *
+                             MOTION_PHASE_STEP_MS;
+    if (elapsed < interval) {
+      return false;
+    }
+  }
+
+  lastPhaseTime = now;
+  return true;
+}
+
 // 基类添加handleMotion方法，调用对应的状态处理函数
 void MotionHandler::handleMotion() {
   switch (currentMotionState) {
   case RobotMotionState::NotStarted:
-    handleNotStarted();
+    // 表情等由订阅者在事件分发时处理
+    publishEvent(RobotEventType::MotionStarted,
+                 static_cast<uint8_t>(currentMotionId));
+    if (suspendedMotionId == currentMotionId) {
+      // 打断它的动作已完成，从保存的计数器恢复
+      suspendedMotionId = RobotMotionId::Count;
+      handleResume(suspendedCounter);
+    } else {
+      handleNotStarted();
+    }
     break;
   case RobotMotionState::InProgress:
+    // 未到下一阶段的时间时不推进动作，保持非阻塞
+    if (!phaseDue()) {
+      return; // 等待中不向看门狗报到，等待时间由 phaseDue 限制
+    }
     handleInProgress();
     break;
   case RobotMotionState::Completed:
     handleCompleted();
     break;
   }
+  watchdogCheckin(WatchdogTask::Motion); // 完成了一个动作步骤
 }
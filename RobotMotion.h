@@ -3,9 +3,15 @@
 
 #include <Arduino.h>
 #include "RobotDefines.h"
+#include "RobotGait.h"
 
-// 设置下一个动作ID
-void setMovingState(RobotMotionId motionId);
+// 设置下一个动作ID，可选地附带动作参数
+// 若目标动作正在执行，则参数立即生效
+void setMovingState(RobotMotionId motionId,
+                    const RobotMotionParams &params = RobotMotionParams());
+
+// 检查动作参数是否在有效范围内
+bool validateMotionParams(const RobotMotionParams &params);
 
 // 检查是否有下一个动作，用于配置非阻断式动作
 bool haveNextMotion();
@@ -16,6 +22,26 @@ void SyncMovingState();
 // 更新动作
 void UpdateMotion();
 
+// 动作请求（MotionRequested 事件）的方式
+#define MOTION_REQUEST_SET 0     // 与 setMovingState 相同，当前动作完成后切换
+#define MOTION_REQUEST_SUSPEND 1 // 立即打断当前动作，请求的动作完成后从打断处恢复
+#define MOTION_REQUEST_REPLACE 2 // 立即替换当前动作，被打断的动作在请求的动作完成后照常恢复
+// 请求的 value：低 8 位为请求方式，高 8 位为替换时转向的角度（度，0 表示按周期数）
+#define MOTION_REQUEST_VALUE(how, degrees) ((how) | (static_cast<uint16_t>(degrees) << 8))
+
+// 唱歌按节拍唱完固定数量的音符，不移动舵机
+#define MOTION_SING_NOTES 10    // 一首歌的音符数
+#define MOTION_SING_NOTE_MS 300 // 每个音符的时长（毫秒），必须短于看门狗期限
+
+// 订阅动作请求和测距事件，在 setup() 中调用
+void setupMotionEvents();
+
+// 当前行走周期的转向量（百分比），正值向左
+int8_t currentWalkSteer();
+
+// 正在执行的转向周期的髋关节幅度（度），不在转向时返回 0
+uint8_t currentTurnAmplitude();
+
 // 各个动作已经封装到MotionHandler子类中
 
 // 全局运动状态变量声明
@@ -23,17 +49,111 @@ extern RobotMotionId currentMotionId;
 extern RobotMotionId nextMotionId;
 extern RobotMotionState currentMotionState;
 extern uint16_t sharedCounter;
+extern RobotMotionParams currentMotionParams;
+extern RobotMotionParams nextMotionParams;
 
 class MotionHandler {
 public:
-    RobotMotionId motionId; // 运动ID
     // 处理运动状态的虚函数
     virtual void handleMotion();
     virtual void handleNotStarted();
     virtual void handleInProgress();
     virtual void handleCompleted();
+    // 被打断的动作恢复时调用，counter 为打断时的计数器；默认重新开始
+    virtual void handleResume(uint16_t counter);
+
+protected:
+    // 各动作共用的调参常量，编译期常量不占用 SRAM
+    static constexpr uint8_t centerPos = 90;            // 中心位置
+    static constexpr uint8_t defaultAmplitude = 20;     // 默认髋关节运动幅度
+    static constexpr uint8_t defaultLegLiftHeight = 10; // 默认腿抬起高度
+    // 步态的关节限位按参数上限检查，默认值同样不能超过上限
+    static_assert(defaultAmplitude <= MOTION_AMPLITUDE_MAX &&
+                      defaultLegLiftHeight <= MOTION_LIFT_HEIGHT_MAX,
+                  "default motion parameters exceed the limits");
+
+    // 读取当前动作参数，参数为 0 时返回动作自身的默认值
+    static uint8_t paramAmplitude(uint8_t fallback);
+    static uint8_t paramLiftHeight(uint8_t fallback);
+    static uint8_t paramCycles(uint8_t fallback);
+    // 执行行走周期的第 phase 个阶段（共 8 个），steer 在每个周期开始时生效；
+    // transform 为 GAIT_REVERSE 时向后走
+    static void walkStep(uint8_t phase, uint8_t amplitude, uint8_t liftHeight, int8_t steer,
+                         GaitTransform transform = GAIT_IDENTITY);
+    // 规划转向的周期数：参数指定了角度时按标定表换算，最后一个周期减小幅度，不多转；
+    // 否则按循环次数（缺省为 defaultCycles）转向
+    static void planTurn(bool left, uint8_t defaultCycles);
+    // 第 cycle 个转向周期的髋关节幅度
+    static uint8_t turnCycleAmplitude(uint16_t cycle);
+    // 根据速度参数判断是否到了进入下一阶段的时间
+    static bool phaseDue();
+};
+
+// 动作脚本：把动作写成顺序执行的步骤，不再手写按计数器分支的状态机。
+// 脚本编译为无栈协程（protothread）：每个等待点把 __LINE__ 保存为恢复位置，
+// 返回主循环，下次循环从该处继续，因此仍然不阻塞。状态只有 2 字节的恢复位置，
+// 局部变量在等待后不保留，跨步骤的值放在成员变量中；每行最多一个等待点
+class MotionScriptHandler : public MotionHandler {
+public:
+    // 进行中时每次循环都运行脚本，由脚本自己决定何时进入下一阶段
+    void handleMotion() override;
+    // 重置计数器，从头运行脚本
+    void handleNotStarted() override;
+
+protected:
+    // 脚本主体，用下面的宏编写：从上次等待处继续执行，全部完成时返回 true
+    virtual bool runScript() = 0;
+
+    uint16_t scriptLine = 0;              // 恢复位置，0 表示从头开始
+    static unsigned long scriptWaitStart; // MOTION_WAIT_MS 开始的时间，同一时刻只运行一个脚本
 };
 
-extern MotionHandler *motionHandlers[];
+#define MOTION_SCRIPT_BEGIN() \
+    switch (scriptLine) {     \
+    case 0:
+#define MOTION_SCRIPT_END() \
+    }                       \
+    scriptLine = 0;         \
+    return true
+
+// 等待条件成立，条件已成立时不等待。
+// 停在等待点上时动作任务不向看门狗报到，等待必须短于它的期限（WATCHDOG_DEFAULT_DEADLINE_MS）
+#define MOTION_WAIT_UNTIL(condition)   \
+    do {                               \
+        scriptLine = __LINE__;         \
+        __attribute__((fallthrough));  \
+    case __LINE__:                     \
+        if (!(condition))              \
+            return false;              \
+    } while (0)
+
+// 进入下一阶段：至少等到下一次循环，再等上一阶段的舵机到位并满足速度设置的间隔（见 phaseDue），
+// 然后 sharedCounter 加一（记录和仿真按它统计阶段）
+#define MOTION_NEXT_PHASE()    \
+    do {                       \
+        scriptLine = __LINE__; \
+        return false;          \
+    case __LINE__:             \
+        if (!phaseDue())       \
+            return false;      \
+        sharedCounter++;       \
+    } while (0)
+
+// 等待 ms 毫秒
+#define MOTION_WAIT_MS(ms)                                         \
+    do {                                                           \
+        scriptWaitStart = tickMillis();                            \
+        MOTION_WAIT_UNTIL(tickMillis() - scriptWaitStart >= (ms)); \
+    } while (0)
+
+// 等待开始等待之后发布的 type 类型事件
+#define MOTION_WAIT_EVENT(type)                                      \
+    do {                                                             \
+        takePublishedEvent(RobotEventType::type);                    \
+        MOTION_WAIT_UNTIL(takePublishedEvent(RobotEventType::type)); \
+    } while (0)
+
+// 动作处理器表（位于 flash），按 RobotMotionId 直接索引
+extern MotionHandler *const motionHandlers[];
 
 #endif // ROBOT_MOTION_H
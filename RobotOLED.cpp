@@ -1,5 +1,7 @@
 #include "RobotOLED.h"
 #include "IDebug.h"
+#include "RobotDefines.h"
+#include "RobotRate.h"
 
 #ifdef VSCODE
 #include <cstring>
@@ -11,7 +13,38 @@ int centerX(const char* text) {
     return (OLEDLENGTH - len) / 2;
 }
 
+static const char *pendingFace = nullptr; // 最后请求、尚未显示的表情
+static bool facePending = false;
+
 void showFace(const char *faceName)
+{
+    // 只记录最新的表情，按显示频率刷新，同一周期内的多次请求只显示最后一个
+    pendingFace = faceName;
+    facePending = true;
+}
+
+void updateDisplay()
+{
+    if (rateDue(RateTask::Display))
+    {
+        flushDisplay();
+    }
+}
+
+// 在屏幕上绘制表情
+static void drawFace(const char *faceName);
+
+void flushDisplay()
+{
+    if (!facePending)
+    {
+        return;
+    }
+    facePending = false;
+    drawFace(pendingFace);
+}
+
+static void drawFace(const char *faceName)
 {
     // 显示表情
     if (faceName == nullptr || faceName[0] == '\0')
@@ -111,4 +144,53 @@ void showFace(const char *faceName)
         OLED_Lite::displayText("  ^_^  ", centerX("  ^_^  "), 1);
         OLED_Lite::displayText(" Hello!", centerX(" Hello!"), 2);
     }
-}
\ No newline at end of file
+}
+
+// 根据动作事件选择表情，在主循环的事件分发中执行，不占用动作更新的时间
+static void showFaceForEvent(const RobotEvent &event)
+{
+    RobotMotionId motion = static_cast<RobotMotionId>(event.arg);
+    switch (event.type)
+    {
+    case RobotEventType::MotionStarted:
+        if (motion == RobotMotionId::Idle || motion == RobotMotionId::AutoWalking)
+            showFace("happy");
+        break;
+    case RobotEventType::PhaseAdvanced:
+        if (motion == RobotMotionId::Idle && event.value == 1)
+            showFace("sleepy"); // 空闲一段时间后
+        else if (motion == RobotMotionId::Walking || motion == RobotMotionId::AutoWalking ||
+                 motion == RobotMotionId::WalkingBackward)
+        {
+            if (event.value == 0)
+                showFace("thinking"); // 抬起前右腿和后左腿
+            else if (event.value == 3)
+                showFace("surprised"); // 准备移动身体
+        }
+        else if (motion == RobotMotionId::Dancing)
+        {
+            if (event.value == 0)
+                showFace("excited"); // 准备姿势
+            else if (event.value == 6)
+                showFace("love"); // 对角线动作
+        }
+        break;
+    case RobotEventType::ObstacleDetected:
+        if (motion == RobotMotionId::TurningLeft)
+            showFace("confused");
+        else if (motion == RobotMotionId::TurningRight)
+            showFace("angry");
+        else if (motion == RobotMotionId::Scanning)
+            showFace("thinking"); // 扫描完成后才决定方向
+        break;
+    default:
+        break;
+    }
+}
+
+void setupFaceEvents()
+{
+    subscribeEvents(EVENT_MASK(MotionStarted) | EVENT_MASK(PhaseAdvanced) |
+                        EVENT_MASK(ObstacleDetected),
+                    10, showFaceForEvent);
+}
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "oled_lite.h"
+#include "RobotEvents.h"
 
 // OLED显示的字符长度
 #define OLEDLENGTH 16
@@ -10,7 +11,16 @@
 // 计算文本居中位置的函数声明
 int centerX(const char* text);
 
-// 显示表情函数声明
+// 请求显示表情：只记录最新的请求，由 updateDisplay 按显示频率绘制
 void showFace(const char* face);
 
+// 到了显示刷新时间时绘制最新请求的表情，每次循环调用
+void updateDisplay();
+
+// 立即绘制尚未显示的表情，例如进入睡眠之前
+void flushDisplay();
+
+// 订阅动作事件，根据事件显示对应的表情
+void setupFaceEvents();
+
 #endif // ROBOT_OLED_H
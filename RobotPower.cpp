@@ -0,0 +1,121 @@
+#include "RobotPower.h"
+#include "IDebug.h"
+#include "RobotMotion.h"
+#include "RobotOLED.h"
+#include "RobotServoControl.h"
+#include "RobotTrace.h"
+#include "RobotUS.h"
+
+#if defined(__AVR__)
+#include <avr/power.h>
+#include <avr/sleep.h>
+#endif
+
+static uint16_t idleTimeout = POWER_DEFAULT_IDLE_TIMEOUT_S; // 空闲超时（秒）
+static uint16_t rangingInterval = POWER_DEFAULT_RANGING_MS; // 测距间隔（毫秒）
+
+static bool lowPower = false;         // 是否处于低功耗状态
+static unsigned long idleSince = 0;   // 进入空闲的时间
+static unsigned long lowPowerSince = 0;
+static unsigned long lastRanging = 0; // 上次测距的时间
+
+// 统计
+static uint16_t lowPowerEntries = 0;  // 进入低功耗的次数
+static uint16_t wakeBySerial = 0;     // 被串口命令唤醒的次数
+static uint16_t wakeBySensor = 0;     // 被测距唤醒的次数
+static uint32_t lowPowerMs = 0;       // 舵机断开的累计时间
+static uint32_t sleptMs = 0;          // MCU 睡眠的累计时间
+
+// 让 MCU 进入空闲睡眠，直到任意中断（串口接收、millis 定时器等）到来
+static void sleepUntilInterrupt() {
+#if defined(__AVR__)
+  set_sleep_mode(SLEEP_MODE_IDLE); // 空闲模式下 USART 仍在工作，可被串口接收唤醒
+  power_adc_disable();
+  sleep_enable();
+  sleep_cpu();
+  sleep_disable();
+  power_adc_enable();
+#endif
+}
+
+static void leaveLowPower() {
+  lowPower = false;
+  lowPowerMs += millis() - lowPowerSince;
+}
+
+void updatePower() {
+  unsigned long now = tickMillis();
+
+  // 只有空闲动作已完成且没有等待中的动作时才算空闲
+  bool idle = currentMotionId == RobotMotionId::Idle &&
+              currentMotionState == RobotMotionState::Completed &&
+              !haveNextMotion();
+  if (!idle) {
+    if (lowPower) {
+      leaveLowPower();
+      wakeBySerial++; // 只有串口命令会切换动作
+    }
+    idleSince = now;
+    return;
+  }
+
+  if (!lowPower) {
+    if (idleTimeout == 0 || now - idleSince < idleTimeout * 1000UL) {
+      return;
+    }
+    debuglnF("Entering low power mode.");
+    detachServos();
+    showFace("sleepy");
+    flushDisplay(); // 睡眠期间不刷新显示，先画出表情
+    lowPower = true;
+    lowPowerSince = now;
+    lastRanging = now;
+    lowPowerEntries++;
+  }
+
+  // 定期测距，有物体靠近时重新开始空闲动作（回到站立姿态并显示表情）
+  if (rangingInterval != 0 && now - lastRanging >= rangingInterval) {
+    lastRanging = now;
+    if (getUSDistance() < POWER_WAKE_DISTANCE) {
+      debuglnF("Woken by sensor.");
+      leaveLowPower();
+      wakeBySensor++;
+      idleSince = now;
+      currentMotionState = RobotMotionState::NotStarted;
+      return;
+    }
+  }
+
+  // 有待处理的串口数据时不睡眠
+  if (Serial.available() > 0) {
+    return;
+  }
+  unsigned long before = millis();
+  sleepUntilInterrupt();
+  sleptMs += millis() - before;
+}
+
+void setIdleTimeout(uint16_t seconds) { idleTimeout = seconds; }
+
+void setIdleRangingInterval(uint16_t ms) { rangingInterval = ms; }
+
+void printPowerStats() {
+  uint32_t detached = lowPowerMs + (lowPower ? millis() - lowPowerSince : 0);
+
+  Serial.println(F("Power stats:"));
+  Serial.print(F("  low power entries: "));
+  Serial.println(lowPowerEntries);
+  Serial.print(F("  woken by serial: "));
+  Serial.println(wakeBySerial);
+  Serial.print(F("  woken by sensor: "));
+  Serial.println(wakeBySensor);
+  Serial.print(F("  servos detached (s): "));
+  Serial.println(detached / 1000);
+  Serial.print(F("  mcu asleep (s): "));
+  Serial.println(sleptMs / 1000);
+  // 估算节省的电量（毫安时）
+  uint32_t savedMas = detached / 1000 * POWER_SERVO_HOLD_MA +
+                      sleptMs / 1000 * (POWER_MCU_ACTIVE_MA - POWER_MCU_SLEEP_MA);
+  Serial.print(F("  estimated saving (mAh): "));
+  Serial.println(savedMas / 3600);
+}
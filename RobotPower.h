@@ -0,0 +1,30 @@
+#ifndef ROBOT_POWER_H
+#define ROBOT_POWER_H
+
+#include <Arduino.h>
+#include "RobotDefines.h"
+
+// 空闲低功耗管理
+// 空闲超过设定时间后断开舵机，并在每次循环中让 MCU 进入空闲睡眠模式。
+// 串口接收或定时器中断会唤醒 MCU；低功耗期间定期测距，有物体靠近时唤醒机器人。
+
+#define POWER_DEFAULT_IDLE_TIMEOUT_S 30   // 默认空闲超时（秒），0 表示不进入低功耗
+#define POWER_DEFAULT_RANGING_MS 1000     // 低功耗期间测距的间隔
+#define POWER_WAKE_DISTANCE 200           // 物体距离小于该值（毫米）时唤醒
+
+// 估算节省电量使用的电流值（毫安）
+#define POWER_SERVO_HOLD_MA (10 * ROBOT_SERVOS) // 所有舵机保持姿态的总电流
+#define POWER_MCU_ACTIVE_MA 15 // MCU 全速运行
+#define POWER_MCU_SLEEP_MA 6   // MCU 空闲睡眠
+
+// 每次循环调用，处理空闲超时、睡眠和唤醒
+void updatePower();
+
+// 设置空闲超时（秒）和测距间隔（毫秒）
+void setIdleTimeout(uint16_t seconds);
+void setIdleRangingInterval(uint16_t ms);
+
+// 通过串口输出低功耗统计信息
+void printPowerStats();
+
+#endif // ROBOT_POWER_H
@@ -0,0 +1,98 @@
+#include "RobotRate.h"
+#include "RobotTrace.h"
+
+struct RateState
+{
+  uint8_t hz;         // 设定频率
+  uint8_t remainder;  // 周期不是整毫秒时累积的余数，保证平均频率准确
+  uint16_t next;      // 下一次更新的时间（毫秒，低 16 位）
+  uint16_t lastPoll;  // 上次查询的时间
+  uint16_t updates;   // 统计窗口内的更新次数
+  uint32_t activeMs;  // 统计窗口内任务需要更新的时间
+};
+
+static const uint8_t taskCount = static_cast<uint8_t>(RateTask::Count);
+static RateState rates[taskCount] = {
+    {RATE_SERVO_DEFAULT_HZ, 0, 0, 0, 0, 0},
+    {RATE_US_DEFAULT_HZ, 0, 0, 0, 0, 0},
+    {RATE_DISPLAY_DEFAULT_HZ, 0, 0, 0, 0, 0},
+};
+static_assert(sizeof(rates) / sizeof(rates[0]) == taskCount, "rates must cover every RateTask");
+
+bool rateDue(RateTask task)
+{
+  RateState &state = rates[static_cast<uint8_t>(task)];
+  const uint16_t now = static_cast<uint16_t>(tickMillis());
+  const uint16_t period = 1000 / state.hz;
+
+  // 任务暂停期间（两次查询相隔超过两个周期）只按一个周期计入需要更新的时间
+  const uint16_t gap = now - state.lastPoll;
+  state.activeMs += gap < 2 * period ? gap : period;
+  state.lastPoll = now;
+
+  if (static_cast<int16_t>(now - state.next) < 0)
+  {
+    return false;
+  }
+  state.updates++;
+  state.next += period;
+  state.remainder += 1000 % state.hz;
+  if (state.remainder >= state.hz)
+  {
+    state.remainder -= state.hz;
+    state.next++;
+  }
+  if (static_cast<int16_t>(now - state.next) >= 0)
+  {
+    state.next = now + period;
+    state.remainder = 0;
+  }
+  return true;
+}
+
+void setTaskRate(RateTask task, uint8_t hz)
+{
+  RateState &state = rates[static_cast<uint8_t>(task)];
+  state.hz = hz;
+  state.remainder = 0;
+  state.updates = 0;
+  state.activeMs = 0;
+}
+
+uint8_t getTaskRate(RateTask task)
+{
+  return rates[static_cast<uint8_t>(task)].hz;
+}
+
+// 输出一个任务的设定频率和实际频率，然后重新统计
+static void printRate(const __FlashStringHelper *name, RateTask task)
+{
+  RateState &state = rates[static_cast<uint8_t>(task)];
+  Serial.print(F("  "));
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.print(state.hz);
+  Serial.print(F(" / "));
+  if (state.activeMs == 0)
+  {
+    Serial.println(F("idle"));
+  }
+  else
+  {
+    // 保留一位小数
+    uint32_t tenths = static_cast<uint32_t>(state.updates) * 10000UL / state.activeMs;
+    Serial.print(tenths / 10);
+    Serial.print('.');
+    Serial.println(tenths % 10);
+  }
+  state.updates = 0;
+  state.activeMs = 0;
+}
+
+void printRateStats()
+{
+  Serial.println(F("Rate stats (Hz, requested / achieved):"));
+  printRate(F("servos"), RateTask::Servos);
+  printRate(F("sensing"), RateTask::Sensing);
+  printRate(F("display"), RateTask::Display);
+}
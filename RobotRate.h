@@ -0,0 +1,38 @@
+#ifndef ROBOT_RATE_H
+#define ROBOT_RATE_H
+
+#include <Arduino.h>
+
+// 多速率调度
+// 主循环尽快运行，舵机模型、超声波测距和显示按各自的频率更新，频率可以在运行时修改。
+// 子系统之间只交换最新的数据（最新的测距读数、最后请求的表情），
+// 慢的子系统不会拖慢快的子系统，CPU 时间和 I2C 总线留给需要的地方。
+
+#define RATE_SERVO_DEFAULT_HZ 50  // 舵机模型与电流预算调度，与舵机脉冲的 20ms 帧一致
+#define RATE_US_DEFAULT_HZ 16     // 超声波测距，模块建议两次测距间隔不小于 60ms，62.5ms 最接近
+#define RATE_DISPLAY_DEFAULT_HZ 4 // 表情刷新，每次刷新都要清屏并通过 I2C 写两行文字
+#define RATE_US_MAX_HZ 16         // 测距频率上限（间隔不小于 60ms）
+#define RATE_MAX_HZ 200           // 其他任务的频率上限
+
+// 按频率更新的任务
+enum class RateTask : uint8_t
+{
+  Servos,
+  Sensing,
+  Display,
+  Count // 任务数量，必须位于最后
+};
+
+// 任务需要更新时每次循环调用：到了更新时间时返回 true。
+// 落后超过一个周期时（循环被阻塞，或任务暂停后重新开始）不补发，从现在重新计时
+bool rateDue(RateTask task);
+
+// 设置任务的频率（Hz），调用方负责检查范围
+void setTaskRate(RateTask task, uint8_t hz);
+uint8_t getTaskRate(RateTask task);
+
+// 输出各任务的设定频率和自上次查询以来的实际频率，然后重新统计。
+// 实际频率只统计任务需要更新的时间，例如只在有动作需要测距时统计测距
+void printRateStats();
+
+#endif // ROBOT_RATE_H
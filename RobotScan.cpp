@@ -0,0 +1,284 @@
+#include "RobotScan.h"
+#include "RobotDefines.h"
+
+static AvoidMode avoidMode = AvoidMode::Alternate;
+
+static int scanDistance[SCAN_BINS]; // 最近一次扫描的距离表（毫米）
+static int8_t lastSide = 0;         // 上次转向的一侧：1 左，-1 右
+static bool stuck = false;          // 上次避障后几乎没有前进
+static int aheadDistance = 0;       // 自动行走发现障碍时正前方的距离
+static int8_t firstSide = 1;        // 本次扫描先测量的一侧
+static int8_t arcSide = 0;          // 正在绕行的方向，0 表示没有绕行
+static bool aimPending = false;     // 已转向所选方向，还没有重新测量
+
+// 统计
+static uint16_t scanCount = 0;    // 完成的扫描次数
+static uint16_t scanLeft = 0;     // 选择左转的次数
+static uint16_t scanRight = 0;    // 选择右转的次数
+static uint16_t scanStraight = 0; // 正前方已空闲的次数
+static uint16_t scanBlocked = 0;  // 扇区内没有空闲方向的次数
+static uint16_t arcCount = 0;     // 边走边转的次数
+static uint16_t arcCleared = 0;   // 没有停下就绕开了障碍的次数
+
+// 反应延迟分布，各区间的上限（毫秒）为 1、4、16、64，最后一个区间没有上限
+#define LATENCY_BUCKETS 5
+static uint16_t latencyCount[LATENCY_BUCKETS];
+static uint32_t latencySumUs = 0;
+static uint32_t latencyMaxUs = 0;
+
+void setAvoidMode(AvoidMode mode) { avoidMode = mode; }
+
+AvoidMode getAvoidMode() { return avoidMode; }
+
+int8_t scanBinAngle(uint8_t bin) {
+  return (static_cast<int8_t>(bin) - SCAN_BINS / 2) * SCAN_STEP_DEG;
+}
+
+void noteAvoidance(uint16_t walkedPhases, int distance) {
+  stuck = walkedPhases < SCAN_STUCK_PHASES;
+  aheadDistance = distance;
+  arcSide = 0; // 绕行没能避开障碍
+}
+
+void noteTurnSide(bool left) { lastSide = left ? 1 : -1; }
+
+int8_t avoidSteer(int distance) {
+  if (distance >= STEER_DISTANCE_MM) {
+    if (arcSide != 0) {
+      arcSide = 0;
+      arcCleared++;
+    }
+    return 0;
+  }
+  if (arcSide == 0) {
+    // 沿用上次转向的一侧，连续的障碍（例如墙）通常在同一侧绕开
+    arcSide = lastSide != 0 ? lastSide : 1;
+    arcCount++;
+  }
+  int steer = STEER_MIN + static_cast<long>(STEER_DISTANCE_MM - distance) *
+                              (MOTION_STEER_MAX - STEER_MIN) /
+                              (STEER_DISTANCE_MM - AVOID_DISTANCE_MM);
+  if (steer > MOTION_STEER_MAX) {
+    steer = MOTION_STEER_MAX;
+  }
+  return arcSide * steer;
+}
+
+void beginScan() {
+  for (uint8_t i = 0; i < SCAN_BINS; i++) {
+    scanDistance[i] = 0;
+  }
+  // 正前方刚刚测过，不需要再测
+  scanDistance[SCAN_BINS / 2] = aheadDistance;
+  firstSide = lastSide != 0 ? lastSide : 1;
+}
+
+// 一侧的方向是否都已空闲
+static bool sideClear(int8_t side) {
+  for (uint8_t i = 1; i <= SCAN_BINS / 2; i++) {
+    if (scanDistance[SCAN_BINS / 2 + side * i] < SCAN_CLEAR_MM) {
+      return false;
+    }
+  }
+  return true;
+}
+
+uint8_t scanBinAt(uint8_t step) {
+  // 先由近到远测量一侧，再测量另一侧
+  const uint8_t half = SCAN_BINS / 2;
+  if (step < half) {
+    return half + firstSide * (step + 1);
+  }
+  // 第一侧已全部空闲时不需要再看另一侧；被困时只会在上次转向的一侧选择方向
+  if (step >= 2 * half || sideClear(firstSide) || (stuck && lastSide != 0)) {
+    return SCAN_BINS;
+  }
+  return half - firstSide * (step - half + 1);
+}
+
+void recordScan(uint8_t bin, int distance) {
+  if (bin < SCAN_BINS) {
+    scanDistance[bin] = distance;
+  }
+}
+
+int scanBinDistance(uint8_t bin) { return bin < SCAN_BINS ? scanDistance[bin] : 0; }
+
+// 距离 distance 处留出半个机身宽度需要的角度（度），按小角度近似
+static int bodyMarginDeg(int distance) {
+  if (distance <= 0) {
+    return 90;
+  }
+  long margin = BODY_WIDTH_MM * 573L / (20L * distance); // 半宽 / 距离 × 57.3
+  return margin > 90 ? 90 : static_cast<int>(margin);
+}
+
+// 从第 start 个方向开始的 length 个方向能让机身通过的范围（度），不能通过时返回 false。
+// 这几个方向覆盖的扇区两侧各减去半个机身宽度的余量，余下的范围为空时说明空隙比机身窄
+static bool usableRun(uint8_t start, uint8_t length, int clearance, int &low, int &high) {
+  const int half = SCAN_STEP_DEG / 2;
+  const int margin = bodyMarginDeg(clearance);
+  low = scanBinAngle(start) - half + margin;
+  high = scanBinAngle(start + length - 1) + half - margin;
+  return low <= high;
+}
+
+ScanDecision chooseScanBearing() {
+  // 上次避障后几乎没有前进时，只在上次转向的一侧选择方向，
+  // 避免在两个都走不通的方向之间来回转
+  uint8_t from = 0, to = SCAN_BINS;
+  if (stuck && lastSide > 0) {
+    from = SCAN_BINS / 2 + 1;
+  } else if (stuck && lastSide < 0) {
+    to = SCAN_BINS / 2;
+  }
+
+  // 找出能让机身通过的最宽的连续空闲方向，宽度相同时选最近距离更大的一段
+  bool found = false;
+  int bestLow = 0, bestHigh = 0, bestClearance = 0;
+  uint8_t start = 0, length = 0;
+  int clearance = 0;
+  for (uint8_t i = from; i <= to; i++) {
+    if (i < to && scanDistance[i] >= SCAN_CLEAR_MM) {
+      if (length == 0) {
+        start = i;
+        clearance = scanDistance[i];
+      }
+      length++;
+      if (scanDistance[i] < clearance) {
+        clearance = scanDistance[i];
+      }
+      continue;
+    }
+    int low, high;
+    if (length != 0 && usableRun(start, length, clearance, low, high) &&
+        (!found || high - low > bestHigh - bestLow ||
+         (high - low == bestHigh - bestLow && clearance > bestClearance))) {
+      found = true;
+      bestLow = low;
+      bestHigh = high;
+      bestClearance = clearance;
+    }
+    length = 0;
+  }
+
+  if (!found) {
+    // 没有空闲方向时，退而选择最远且不需要避障的方向，同样要能让机身通过
+    uint8_t farthest = from;
+    for (uint8_t i = from + 1; i < to; i++) {
+      if (scanDistance[i] > scanDistance[farthest]) {
+        farthest = i;
+      }
+    }
+    if (scanDistance[farthest] >= AVOID_DISTANCE_MM) {
+      found = usableRun(farthest, 1, scanDistance[farthest], bestLow, bestHigh);
+      bestClearance = scanDistance[farthest];
+    }
+  }
+
+  scanCount++;
+  ScanDecision decision;
+  if (!found) {
+    // 都有障碍，转向距离总和更大的一侧（被困时沿用上次的一侧），并转过扇区之外
+    int8_t side = lastSide;
+    if (!stuck || side == 0) {
+      long left = 0, right = 0;
+      for (uint8_t i = 0; i < SCAN_BINS / 2; i++) {
+        right += scanDistance[i];
+        left += scanDistance[SCAN_BINS - 1 - i];
+      }
+      side = left >= right ? 1 : -1;
+    }
+    decision.bearing = side * SCAN_BLOCKED_DEG;
+    decision.degrees = SCAN_BLOCKED_DEG;
+    decision.distance = side > 0 ? scanDistance[SCAN_BINS - 1] : scanDistance[0];
+    scanBlocked++;
+  } else {
+    // 瞄准能通过的范围的中间。偏差不超过扫描的分辨率、而且正前方本身就能通过时不转；
+    // 正前方在范围之外时即使偏差很小也要转，否则机身会擦到空隙的边缘
+    int bearing = (bestLow + bestHigh) / 2;
+    if (bearing > -SCAN_STEP_DEG / 2 && bearing < SCAN_STEP_DEG / 2 && bestLow <= 0 &&
+        bestHigh >= 0) {
+      bearing = 0;
+    }
+    decision.bearing = static_cast<int8_t>(bearing);
+    decision.degrees = bearing < 0 ? -bearing : bearing;
+    decision.distance = bestClearance;
+  }
+
+  // 转向之后重新测量前方，确认对准了空隙
+  aimPending = decision.degrees != 0;
+  if (decision.degrees == 0) {
+    scanStraight++;
+  } else if (decision.bearing > 0) {
+    lastSide = 1;
+    scanLeft++;
+  } else {
+    lastSide = -1;
+    scanRight++;
+  }
+  return decision;
+}
+
+bool takeScanAimCheck() {
+  bool pending = aimPending;
+  aimPending = false;
+  return pending;
+}
+
+void recordReactionLatency(unsigned long us) {
+  uint8_t bucket = 0;
+  for (unsigned long limit = 1000; bucket < LATENCY_BUCKETS - 1 && us >= limit; limit *= 4) {
+    bucket++;
+  }
+  latencyCount[bucket]++;
+  latencySumUs += us;
+  if (us > latencyMaxUs) {
+    latencyMaxUs = us;
+  }
+}
+
+void printScanStats() {
+  Serial.println(F("Scan stats:"));
+  Serial.print(F("  mode: "));
+  Serial.println(avoidMode == AvoidMode::Steer  ? F("steer")
+                 : avoidMode == AvoidMode::Scan ? F("scan")
+                                                : F("alternate"));
+  Serial.print(F("  scans: "));
+  Serial.println(scanCount);
+  Serial.print(F("  turned left / right / straight: "));
+  Serial.print(scanLeft);
+  Serial.print(F(" / "));
+  Serial.print(scanRight);
+  Serial.print(F(" / "));
+  Serial.println(scanStraight);
+  Serial.print(F("  blocked: "));
+  Serial.println(scanBlocked);
+  Serial.print(F("  arcs / cleared without stopping: "));
+  Serial.print(arcCount);
+  Serial.print(F(" / "));
+  Serial.println(arcCleared);
+  uint16_t reactions = 0;
+  for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+    reactions += latencyCount[i];
+  }
+  Serial.print(F("  reaction latency mean / max (us): "));
+  Serial.print(reactions ? latencySumUs / reactions : 0UL);
+  Serial.print(F(" / "));
+  Serial.println(latencyMaxUs);
+  Serial.print(F("  reaction latency <1 <4 <16 <64 >=64 ms:"));
+  for (uint8_t i = 0; i < LATENCY_BUCKETS; i++) {
+    Serial.print(' ');
+    Serial.print(latencyCount[i]);
+  }
+  Serial.println();
+  // 最近一次的距离表，从右到左
+  Serial.print(F("  last map (deg:mm):"));
+  for (uint8_t i = 0; i < SCAN_BINS; i++) {
+    Serial.print(' ');
+    Serial.print(scanBinAngle(i));
+    Serial.print(':');
+    Serial.print(scanDistance[i]);
+  }
+  Serial.println();
+}
@@ -0,0 +1,77 @@
+#ifndef ROBOT_SCAN_H
+#define ROBOT_SCAN_H
+
+#include <Arduino.h>
+
+// 扫描避障
+// 遇到障碍时四脚着地，同时转动所有髋关节让身体左右扭转，在扇区内的几个方向上测距，
+// 得到一个极坐标距离表，然后转向最宽的空闲方向，而不是轮流向左、向右转。
+
+#define SCAN_BINS 7              // 扫描的方向数
+#define SCAN_STEP_DEG 15         // 相邻方向之间的髋关节角度（度），扇区为 ±45 度
+#define AVOID_DISTANCE_MM 400    // 自动行走时前方距离小于该值（毫米）开始避障
+#define SCAN_CLEAR_MM 600        // 距离不小于该值的方向视为空闲，留出走几步的余量
+#define BODY_WIDTH_MM 140        // 机身宽度（毫米），空隙至少要这么宽才转过去
+#define SCAN_BLOCKED_DEG 80       // 扇区内没有空闲方向时转过的角度，转到扇区之外
+#define SCAN_STUCK_PHASES 16     // 两次避障之间前进的阶段数少于该值时视为被困
+#define STEER_DISTANCE_MM 650    // 前方距离小于该值时边走边转，直到小于避障距离才停下
+#define STEER_MIN 25             // 开始转向时的最小转向量（百分比）
+
+// 避障方式
+enum class AvoidMode : uint8_t
+{
+  Alternate, // 轮流向左、向右转
+  Scan,      // 扫描后转向最宽的空闲方向
+  Steer      // 先边走边转绕开障碍，太近时再轮流向左、向右转
+};
+
+void setAvoidMode(AvoidMode mode);
+AvoidMode getAvoidMode();
+
+// 第 bin 个方向对应的髋关节偏移（度），正值为逆时针（向左）
+int8_t scanBinAngle(uint8_t bin);
+
+// 由自动行走在遇到障碍时调用，记录上次避障后前进了多少个阶段，以及正前方的距离
+void noteAvoidance(uint16_t walkedPhases, int distance);
+
+// 记录不经扫描直接选择的转向一侧，left 为 true 时向左
+void noteTurnSide(bool left);
+
+// 由自动行走在每个阶段调用，返回绕开前方障碍需要的转向量（百分比），不需要转向时返回 0。
+// 距离越近转得越急；一次绕行中保持同一个方向
+int8_t avoidSteer(int distance);
+
+// 开始新的扫描，清空距离表并填入正前方的距离
+void beginScan();
+// 第 step 次测量的方向，扫描结束时返回 SCAN_BINS。
+// 先由近到远测量上次转向的一侧，这一侧都已空闲时不再测量另一侧
+uint8_t scanBinAt(uint8_t step);
+
+// 记录第 bin 个方向的距离（毫米）
+void recordScan(uint8_t bin, int distance);
+// 最近一次扫描第 bin 个方向的距离（毫米），没有测量时为 0
+int scanBinDistance(uint8_t bin);
+
+// 扫描结果
+struct ScanDecision
+{
+  int8_t bearing; // 选择的方向（度），正值向左
+  uint8_t degrees; // 需要转过的角度，0 表示正前方已空闲，不需要转向
+  int distance;   // 所选方向的距离（毫米）
+};
+
+// 根据距离表选择能让机身通过的最宽的空闲方向，瞄准两侧各留出半个机身宽度后的中间
+ScanDecision chooseScanBearing();
+
+// 上次扫描后转向了所选方向时返回 true，并清除标记。
+// 自动行走据此要求转向后的第一次测距也是空闲的，否则重新扫描
+bool takeScanAimCheck();
+
+// 记录一次避障反应延迟（微秒）：从障碍最早可能被测到的时间（上一次测距开始，包括等待下一次测距的时间），
+// 到停止姿态的脉冲由脉冲引擎真正输出（包括被电流预算推迟的舵机）
+void recordReactionLatency(unsigned long us);
+
+// 通过串口输出最近一次的距离表、扫描统计和反应延迟分布
+void printScanStats();
+
+#endif // ROBOT_SCAN_H
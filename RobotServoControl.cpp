@@ -1,45 +1,326 @@
 #include "RobotServoControl.h"
 #include "IDebug.h"
+#include "RobotClip.h"
+#include "RobotTrace.h"
+#include "ServoPulse.h"
 
 // 外部引用加载器
 extern IRobot::ServoTrim trimLoader;
 extern IRobot::ServoReverse reverseLoader;
+extern IRobot::ServoPose poseLoader;
 
-// 舵机引脚定义
-uint8_t board_pins[8] = {2, 8, 3, 9, 4, 6, 5, 7};
-Servo servos[8];                                  // 创建多个Servo对象
+// 舵机的引脚由 BodyLayout 给出（见 RobotDefines.h），各数组按舵机数量静态分配
 bool ifServoInit = false;                         // 是否已初始化舵机
+static bool poseBatching = false;                 // 是否正在批量设置姿态
 
-void initServos()
+// 修剪和反转预先折算为线性映射：输出角度 = base + sign * 目标角度（0.1 度）
+static int16_t channelBase[ROBOT_SERVOS];
+static int8_t channelSign[ROBOT_SERVOS];
+
+// 影子姿态：记录每个通道上一次的目标角度和实际输出角度，用于跳过重复写入
+#define SHADOW_UNKNOWN 0x7FFF // 不会出现的角度，表示需要重新写入
+static int16_t shadowTarget[ROBOT_SERVOS];
+static int16_t shadowOutput[ROBOT_SERVOS];
+
+// 已发送给脉冲引擎的输出角度。受电流预算限制，可能暂时落后于 shadowOutput
+static int16_t issuedOutput[ROBOT_SERVOS];
+
+// 舵机实际位置的估计值（输出角度，0.1 度），按转速限制向已发送的角度逼近
+static int16_t estimatedOutput[ROBOT_SERVOS];
+static uint16_t slewRate = SERVO_DEFAULT_SLEW_RATE; // 舵机转速（度/秒）
+static unsigned long lastModelUpdate = 0;           // 上次更新估计值的时间
+
+// 电流预算：同时转动的舵机成本之和不超过预算
+static uint8_t currentBudget = SERVO_DEFAULT_CURRENT_BUDGET;
+static ServoMask deferredMask = 0; // 已计入推迟次数、仍在等待的通道
+static uint8_t nextChannel = 0;    // 轮询起点，避免编号小的通道总是优先
+
+// 软启动：上电后从保存的姿态开始，逐个连接舵机并缓慢逼近目标
+static ServoMask attachedMask = 0;     // 已开始输出脉冲的通道
+static bool softStartActive = false;   // 是否处于软启动阶段
+static unsigned long softStartBegin = 0;
+static unsigned long lastRampTime = 0; // 上次推进软启动斜坡的时间
+static uint16_t attachBudget = SERVO_DEFAULT_ATTACH_BUDGET_MS;
+
+// 等待输出的姿态：姿态中的舵机全部发送后用 commitMarked 提交，开始输出时回调
+static void (*emissionDone)(unsigned long us) = nullptr;
+static unsigned long emissionSince = 0;
+static bool emissionMarked = false;
+
+// 写入统计
+static uint32_t servoWrites = 0;   // 实际写入次数
+static uint32_t servoElided = 0;   // 因无变化而跳过的次数
+static uint32_t servoDeferred = 0; // 因电流预算而推迟启动的次数
+
+// 每个通道转动时的电流成本估计，腿部舵机承重，成本更高
+static inline uint8_t channelCost(uint8_t id)
 {
-  debuglnF("Initializing servos...");
-  for (int i = 0; i < 8; i++)
+  return BodyLayout::jointOf(id) != 0 ? SERVO_COST_LEG : SERVO_COST_HIP;
+}
+
+// 已连接的舵机都已把目标发送给脉冲引擎，没有被电流预算推迟或仍在软启动斜坡上的
+static bool poseIssued()
+{
+  for (uint8_t i = 0; i < ROBOT_SERVOS; i++)
+  {
+    if ((attachedMask & BodyLayout::bit(i)) && shadowOutput[i] != SHADOW_UNKNOWN &&
+        shadowOutput[i] != issuedOutput[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 在电流预算允许的范围内启动等待中的舵机
+static void issueQueuedMoves()
+{
+  if (poseBatching)
+  {
+    return; // 批量设置时等待 commitServoPose
+  }
+
+  // 统计正在转动的舵机的成本
+  uint8_t load = 0;
+  for (uint8_t i = 0; i < ROBOT_SERVOS; i++)
+  {
+    if (estimatedOutput[i] != issuedOutput[i])
+    {
+      load += channelCost(i);
+    }
+  }
+
+  // 软启动阶段按时间推进斜坡，保证整个 0-180 度的行程在一半预算内完成
+  int16_t rampStep = 0;
+  if (softStartActive)
+  {
+    unsigned long now = tickMillis();
+    uint32_t step = (now - lastRampTime) * 3600UL / attachBudget;
+    if (step != 0)
+    {
+      lastRampTime = now;
+      rampStep = step > 1800 ? 1800 : static_cast<int16_t>(step);
+    }
+  }
+
+  bool issued = false;
+  for (uint8_t n = 0; n < ROBOT_SERVOS; n++)
+  {
+    uint8_t i = (nextChannel + n) % ROBOT_SERVOS;
+    int16_t target = shadowOutput[i];
+    if (!(attachedMask & BodyLayout::bit(i)) || target == SHADOW_UNKNOWN ||
+        target == issuedOutput[i])
+    {
+      continue; // 尚未连接、没有目标或已经发送
+    }
+    if (softStartActive)
+    {
+      if (rampStep == 0)
+      {
+        continue;
+      }
+      target = constrain(target, issuedOutput[i] - rampStep,
+                         issuedOutput[i] + rampStep);
+    }
+
+    // 已在转动的舵机改变目标不增加负载；单个舵机在空闲时总是可以启动
+    bool moving = estimatedOutput[i] != issuedOutput[i];
+    if (!moving && load != 0 && load + channelCost(i) > currentBudget)
+    {
+      if (!(deferredMask & BodyLayout::bit(i)))
+      {
+        deferredMask |= BodyLayout::bit(i);
+        servoDeferred++;
+      }
+      continue;
+    }
+    if (!moving)
+    {
+      load += channelCost(i);
+    }
+    deferredMask &= ~BodyLayout::bit(i);
+    issuedOutput[i] = target;
+    ServoPulse::writeDeciDegrees(i, target);
+    issued = true;
+    nextChannel = (i + 1) % ROBOT_SERVOS;
+  }
+
+  // 等待输出的姿态全部发送后，记录它开始输出的时间
+  if (emissionDone && !emissionMarked && poseIssued())
+  {
+    ServoPulse::commitMarked();
+    emissionMarked = true;
+  }
+  else if (issued)
+  {
+    ServoPulse::commit();
+  }
+}
+
+// 软启动阶段按时间逐个开始输出脉冲，前一半预算内连接完所有舵机
+static void serviceSoftStart()
+{
+  if (!softStartActive)
+  {
+    return;
+  }
+  unsigned long elapsed = tickMillis() - softStartBegin;
+  unsigned long due = elapsed >= attachBudget ? ROBOT_SERVOS : 1 + elapsed * (2 * ROBOT_SERVOS) / attachBudget;
+  bool attached = false;
+  for (uint8_t i = 0; i < ROBOT_SERVOS && i < due; i++)
   {
-    servos[i].attach(board_pins[i]); // 连接每个舵机到对应引脚
-    servos[i].write(90);             // 初始化所有舵机到中心位置
+    if (attachedMask & BodyLayout::bit(i))
+    {
+      continue;
+    }
+    // 从保存的姿态开始输出，舵机上电时几乎不需要转动
+    ServoPulse::writeDeciDegrees(i, issuedOutput[i]);
+    attachedMask |= BodyLayout::bit(i);
+    attached = true;
     debugF("Servo ");
     debug(i);
     debugF(" attached to pin ");
-    debugln(board_pins[i]);
+    debugln(BodyLayout::pin(i));
+  }
+  if (attached)
+  {
+    ServoPulse::commit();
+  }
+  if (elapsed >= attachBudget)
+  {
+    softStartActive = false;
+  }
+}
+
+void initServos()
+{
+  debuglnF("Initializing servos...");
+  for (int i = 0; i < ROBOT_SERVOS; i++)
+  {
+    ServoPulse::attach(i, BodyLayout::pin(i)); // 绑定引脚，此时尚不输出脉冲
+    // 假定舵机停在上次保存的姿态
+    estimatedOutput[i] = poseLoader.get(i) * 10;
+    issuedOutput[i] = estimatedOutput[i];
+  }
+  ServoPulse::begin(); // 启动脉冲输出
+  refreshServoMapping();
+
+  attachedMask = 0;
+  softStartActive = true;
+  softStartBegin = tickMillis();
+  lastRampTime = softStartBegin;
+  serviceSoftStart();
+}
+
+void refreshServoMapping()
+{
+  for (int i = 0; i < ROBOT_SERVOS; i++)
+  {
+    int16_t trim = trimLoader.get(i) * 10;
+    if (reverseLoader.get(i))
+    {
+      channelBase[i] = 1800 - trim;
+      channelSign[i] = -1;
+    }
+    else
+    {
+      channelBase[i] = trim;
+      channelSign[i] = 1;
+    }
+    // 映射变化后需要重新写入所有通道
+    shadowTarget[i] = SHADOW_UNKNOWN;
+    shadowOutput[i] = SHADOW_UNKNOWN;
   }
 }
 
 void setServo(int id, int target)
+{
+  // 先粗略限制范围，避免换算为 0.1 度时溢出，精确的限制在 setServoDeci 中
+  target = constrain(target, -1000, 1000);
+  clipRecordServo(id, target); // 录制片段时记录目标角度
+  setServoDeci(id, target * 10);
+}
+
+// 如果舵机未初始化，先初始化
+static void ensureServosInit()
 {
   if (!ifServoInit)
   {
-    initServos();       // 如果舵机未初始化，先初始化
+    initServos();
     ifServoInit = true; // 设置标志位，避免重复初始化
   }
+}
+
+// 按修剪和反转映射换算目标角度（0.1 度，已在 0-180 度之内），交给调度器输出
+static void outputServoDeci(uint8_t id, int target)
+{
+  debugF("Setting servo ID: ");
+  debug(id);
+  debugF(", target angle (0.1 deg): ");
+  debug(target);
+
+  // 使用预先计算的修剪和反转映射
+  int angle = channelBase[id] + channelSign[id] * target;
+
+  // 修剪值可能使输出超出范围，限制在有效范围内
+  if (angle < 0)
+    angle = 0;
+
+  if (angle > 1800)
+    angle = 1800;
+
+  debugF(", final angle (0.1 deg): ");
+  debug(angle);
+  debuglnF(".");
+
+  // 不同的目标可能被限制为相同的输出角度
+  if (shadowOutput[id] == angle)
+  {
+    servoElided++;
+    return;
+  }
+  updateServoModel(); // 先按旧目标推进估计位置，再切换到新目标
+  shadowOutput[id] = angle;
+  servoWrites++;
+
+  // 由调度器决定何时真正发送，避免过多舵机同时启动导致电压跌落
+  issueQueuedMoves();
+}
+
+void setServoTrusted(uint8_t id, uint8_t target)
+{
+  clipRecordServo(id, target);
+  ensureServosInit();
+  const int deci = target * 10;
+  if (shadowTarget[id] == deci)
+  {
+    servoElided++;
+    return;
+  }
+  shadowTarget[id] = deci;
+  outputServoDeci(id, deci);
+}
+
+void setServoDeci(int id, int target)
+{
+  ensureServosInit();
 
   // 检查舵机ID是否在有效范围内
-  if (id < 0 || id > 7)
+  if (id < 0 || id >= ROBOT_SERVOS)
   {
     debugF("Invalid servo ID: ");
     debugln(id);
     return;
   }
 
+  // 目标角度与上次相同，无需任何处理
+  if (shadowTarget[id] == target)
+  {
+    servoElided++;
+    return;
+  }
+  shadowTarget[id] = target;
+
   // 首先限制目标角度在0-180度范围内，防止异常值传入
   if (target < 0)
   {
@@ -47,42 +328,189 @@ void setServo(int id, int target)
     debugln(target);
     target = 0;
   }
-  if (target > 180)
+  if (target > 1800)
   {
     debugF("Warning: Servo angle greater than 180, corrected to: ");
     debugln(target);
-    target = 180;
+    target = 1800;
   }
+  outputServoDeci(id, target);
+}
 
-  debugF("Setting servo ID: ");
-  debug(id);
-  debugF(", target angle: ");
-  debug(target);
+void setServoSlewRate(uint16_t degreesPerSecond)
+{
+  updateServoModel();
+  slewRate = degreesPerSecond;
+}
 
-  int angle;
-  // 因为现在每个舵机都有自己的Servo对象，所以不需要切换引脚
-  if (reverseLoader.get(id))
+uint16_t getServoSlewRate()
+{
+  return slewRate;
+}
+
+void updateServoModel()
+{
+  // 等待输出的姿态已经开始输出
+  unsigned long emitted;
+  if (emissionMarked && ServoPulse::takeMarkedLatch(emitted))
   {
-    debugF(", reverse: true");
-    angle = 180 - (target + trimLoader.get(id));
+    void (*done)(unsigned long) = emissionDone;
+    emissionDone = nullptr;
+    emissionMarked = false;
+    done(emitted - emissionSince);
   }
-  else
+
+  unsigned long now = tickMillis();
+  // 每毫秒转动 slewRate / 100 个 0.1 度
+  uint32_t step = (now - lastModelUpdate) * slewRate / 100;
+  if (step == 0)
+  {
+    return; // 不足 0.1 度时保留余量到下次更新
+  }
+  lastModelUpdate = now;
+  if (step > 1800)
   {
-    angle = target + trimLoader.get(id);
+    step = 1800;
   }
 
-  // 限制角度在有效范围内
-  if (angle < 0)
-    angle = 0;
+  for (int i = 0; i < ROBOT_SERVOS; i++)
+  {
+    int16_t target = issuedOutput[i];
+    int16_t diff = target - estimatedOutput[i];
+    if (diff > static_cast<int16_t>(step))
+      estimatedOutput[i] += step;
+    else if (diff < -static_cast<int16_t>(step))
+      estimatedOutput[i] -= step;
+    else
+      estimatedOutput[i] = target;
+  }
 
-  if (angle > 180)
-    angle = 180;
+  // 有舵机转动到位后，启动被推迟的舵机
+  serviceSoftStart();
+  issueQueuedMoves();
+}
 
-  debugF(", final angle: ");
-  debug(angle);
-  debuglnF(".");
-  // 写入角度到对应的舵机
-  servos[id].write(angle);
-  // 确保舵机有足够时间响应
-  delay(20); // 添加短暂延时以避免同时移动所有舵机
+bool servosSettled()
+{
+  updateServoModel();
+  for (int i = 0; i < ROBOT_SERVOS; i++)
+  {
+    if (shadowOutput[i] != SHADOW_UNKNOWN &&
+        estimatedOutput[i] != shadowOutput[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+int16_t servoEstimatedDeci(int id)
+{
+  if (id < 0 || id >= ROBOT_SERVOS)
+    return 0;
+  updateServoModel();
+  return estimatedOutput[id];
+}
+
+void setServoCurrentBudget(uint8_t budget)
+{
+  currentBudget = budget;
+  issueQueuedMoves();
+}
+
+uint8_t getServoCurrentBudget()
+{
+  return currentBudget;
+}
+
+void detachServos()
+{
+  for (uint8_t i = 0; i < ROBOT_SERVOS; i++)
+  {
+    ServoPulse::detach(i);
+  }
+  ServoPulse::end();
+  attachedMask = 0;
+  softStartActive = false;
+  emissionDone = nullptr; // 不再输出，也就不再等待
+  emissionMarked = false;
+  // 下次设置舵机时重新初始化，并从保存的姿态软启动
+  ifServoInit = false;
+  debuglnF("Servos detached.");
+}
+
+bool servosAttached()
+{
+  return attachedMask != 0;
+}
+
+void setServoAttachBudget(uint16_t ms)
+{
+  attachBudget = ms;
+}
+
+uint16_t getServoAttachBudget()
+{
+  return attachBudget;
+}
+
+bool saveServoPose()
+{
+  // 只在舵机到位后保存：此时估计位置等于输出角度，保存的就是舵机实际所在的姿态。
+  // 转动中（或因电流预算尚未启动）时输出角度只是目标，掉电时舵机并不在那里
+  if (!servosSettled())
+  {
+    return false;
+  }
+  for (int i = 0; i < ROBOT_SERVOS; i++)
+  {
+    if (shadowOutput[i] != SHADOW_UNKNOWN)
+    {
+      poseLoader.set(i, (shadowOutput[i] + 5) / 10);
+    }
+  }
+  poseLoader.store();
+  return true;
+}
+
+uint32_t servoWriteCount()
+{
+  return servoWrites;
+}
+
+uint32_t servoElidedCount()
+{
+  return servoElided;
+}
+
+void printServoStats()
+{
+  Serial.println(F("Servo writes:"));
+  Serial.print(F("  written: "));
+  Serial.println(servoWrites);
+  Serial.print(F("  elided: "));
+  Serial.println(servoElided);
+  Serial.print(F("  deferred: "));
+  Serial.println(servoDeferred);
+  Serial.print(F("  current budget: "));
+  Serial.println(currentBudget);
+  ServoPulse::printStats();
+}
+
+void awaitPoseEmission(unsigned long sinceMicros, void (*done)(unsigned long us))
+{
+  emissionDone = done;
+  emissionSince = sinceMicros;
+  emissionMarked = false;
+}
+
+void beginServoPose()
+{
+  poseBatching = true;
+}
+
+void commitServoPose()
+{
+  poseBatching = false;
+  issueQueuedMoves(); // 预算允许的舵机在下一帧开始时一起生效
 }
\ No newline at end of file
@@ -2,10 +2,21 @@
 #define ROBOT_SERVO_CONTROL_H
 
 #include <Arduino.h>
-#include <Servo.h>
 #include "RobotDefines.h"
 #include "loadReverse.h"
 #include "loadTrim.h"
+#include "loadPose.h"
+
+#define SERVO_DEFAULT_SLEW_RATE 400 // 默认舵机转速（度/秒），约 0.15 秒转 60 度
+#define SERVO_SETTLE_TIMEOUT_MS 400 // 等待舵机到位的最长时间
+
+// 电流预算：正在转动的舵机成本之和不超过预算，超出的舵机推迟启动
+#define SERVO_COST_HIP 2               // 髋关节舵机转动时的电流成本
+#define SERVO_COST_LEG 3               // 腿部舵机承重，成本更高
+#define SERVO_DEFAULT_CURRENT_BUDGET 6 // 默认预算，约为两条腿同时抬起
+
+// 软启动：上电时逐个连接舵机，从保存的姿态缓慢转到目标，总时长不超过预算
+#define SERVO_DEFAULT_ATTACH_BUDGET_MS 500
 
 // 初始化舵机
 void initServos();
@@ -16,6 +27,58 @@ void initServos();
 // hip + 代表 逆时针旋转，hip - 代表 顺时针旋转
 void setServo(int id, int target);
 
+// 以 0.1 度为单位设置舵机角度，其余行为与 setServo 相同
+void setServoDeci(int id, int target);
+
+// 内置步态的输出：id 和角度由编译期检查保证有效（见 RobotGait.h），
+// 跳过范围检查和警告，其余行为与 setServo 相同
+void setServoTrusted(uint8_t id, uint8_t target);
+
+// 根据当前的修剪和反转设置重新计算通道映射，修改设置后调用
+void refreshServoMapping();
+
+// 舵机位置模型：按转速估计每个舵机的实际位置
+// 设置转速（度/秒）
+void setServoSlewRate(uint16_t degreesPerSecond);
+uint16_t getServoSlewRate();
+// 按经过的时间推进估计位置，并启动被电流预算推迟的舵机，每次循环调用
+void updateServoModel();
+// 所有舵机的估计位置都已到达目标
+bool servosSettled();
+// 舵机的估计输出角度（0.1 度）
+int16_t servoEstimatedDeci(int id);
+
+// 设置电流预算
+void setServoCurrentBudget(uint8_t budget);
+uint8_t getServoCurrentBudget();
+
+// 设置软启动的总时长（毫秒）
+void setServoAttachBudget(uint16_t ms);
+uint16_t getServoAttachBudget();
+
+// 停止所有舵机的脉冲输出（舵机不再保持力矩），下次设置舵机时自动软启动
+void detachServos();
+bool servosAttached();
+
+// 将当前姿态保存到 EEPROM，作为下次上电软启动的起点。
+// 只在所有舵机到位时保存（保存的是实际所在的姿态，而不是正在转向的目标），
+// 舵机还在转动时不保存并返回 false，由调用者稍后重试
+bool saveServoPose();
+
+// 写入统计：实际写入次数，以及因目标未变化而跳过的次数
+uint32_t servoWriteCount();
+uint32_t servoElidedCount();
+void printServoStats();
+
+// 反应延迟：等待接下来设置的姿态真正由脉冲引擎输出（包括被电流预算推迟的舵机），
+// 然后以从 sinceMicros 到开始输出的时间（微秒）调用 done。先调用这个函数，再设置姿态
+void awaitPoseEmission(unsigned long sinceMicros, void (*done)(unsigned long us));
+
+// 批量设置姿态：在 beginServoPose 与 commitServoPose 之间的 setServo
+// 只暂存目标且不等待，提交后所有舵机在同一帧内一起改变
+void beginServoPose();
+void commitServoPose();
+
 // 旧版本的设置舵机函数，保留用于兼容性
 void _setServo(int id, int target);
 
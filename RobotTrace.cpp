@@ -0,0 +1,249 @@
+#include "RobotTrace.h"
+#include "RobotMotion.h"
+#include <EEPROM.h>
+
+static_assert((TRACE_BUFFER_SIZE & (TRACE_BUFFER_SIZE - 1)) == 0,
+              "TRACE_BUFFER_SIZE must be a power of two");
+
+static bool tracing = false;
+static bool stopping = false;   // 本次循环结束时停止记录
+static unsigned long tickTime = 0;     // 本次循环使用的时间
+static unsigned long lastTickTime = 0; // 上一次记录的循环时间
+
+static uint8_t buffer[TRACE_BUFFER_SIZE];
+static uint8_t head = 0; // 下一个输出位置
+static uint8_t tail = 0; // 下一个写入位置
+static unsigned long lastFlush = 0;
+
+// 连续相同时间增量的循环合并为一条重复记录
+static bool tickOpen = false; // 上一条记录是循环记录，可以继续重复
+static uint16_t lastDelta = 0;
+static uint8_t repeatCount = 0; // 尚未写入的重复次数
+
+// 上一次记录的动作状态
+static uint8_t lastMotionId = 0xFF;
+static uint8_t lastMotionState = 0xFF;
+static uint8_t lastCounter = 0;
+
+// 统计
+static uint32_t traceTicks = 0;  // 记录的循环次数
+static uint32_t traceBytes = 0;  // 记录的字节数
+static uint16_t lostBytes = 0;   // 尚未报告的丢失字节数
+static uint16_t lostTotal = 0;   // 缓冲区满而丢失的字节数
+static unsigned long traceStart = 0;
+static unsigned long traceStop = 0;
+
+static uint8_t used() { return (tail - head) & (TRACE_BUFFER_SIZE - 1); }
+
+// 写入一条完整的记录，空间不足时整条丢弃
+static void put(const uint8_t *data, uint8_t length) {
+  if (lostBytes != 0) {
+    // 先报告之前丢失的数据，回放会在这里停止
+    if (TRACE_BUFFER_SIZE - 1 - used() < 3 + length) {
+      lostBytes += length;
+      lostTotal += length;
+      return;
+    }
+    const uint8_t lost[3] = {TRACE_LOST, static_cast<uint8_t>(lostBytes),
+                             static_cast<uint8_t>(lostBytes >> 8)};
+    lostBytes = 0;
+    put(lost, 3);
+  }
+  if (TRACE_BUFFER_SIZE - 1 - used() < length) {
+    lostBytes += length;
+    lostTotal += length;
+    return;
+  }
+  for (uint8_t i = 0; i < length; i++) {
+    buffer[tail] = data[i];
+    tail = (tail + 1) & (TRACE_BUFFER_SIZE - 1);
+  }
+  traceBytes += length;
+}
+
+static void writeHex(uint8_t value) {
+  static const char digits[] = "0123456789ABCDEF";
+  Serial.write(digits[value >> 4]);
+  Serial.write(digits[value & 0x0F]);
+}
+
+// 输出一行记录
+static void writeLine(const uint8_t *data, uint8_t length) {
+  Serial.write('~');
+  for (uint8_t i = 0; i < length; i++) {
+    writeHex(data[i]);
+  }
+  Serial.println();
+}
+
+// 从缓冲区输出记录。force 为假时只在串口发送缓冲区有空间时输出，不阻塞循环
+static void drain(bool force) {
+  while (used() != 0) {
+    uint8_t count = used();
+    if (!force && count < TRACE_LINE_BYTES && tickTime - lastFlush < TRACE_FLUSH_MS) {
+      return;
+    }
+    if (count > TRACE_LINE_BYTES) {
+      count = TRACE_LINE_BYTES;
+    }
+    if (!force && Serial.availableForWrite() < 2 * count + 3) {
+      return;
+    }
+    uint8_t line[TRACE_LINE_BYTES];
+    for (uint8_t i = 0; i < count; i++) {
+      line[i] = buffer[head];
+      head = (head + 1) & (TRACE_BUFFER_SIZE - 1);
+    }
+    writeLine(line, count);
+    lastFlush = tickTime;
+  }
+}
+
+static void flushRepeats() {
+  if (repeatCount != 0) {
+    const uint8_t record = TRACE_REPEAT | (repeatCount - 1);
+    repeatCount = 0;
+    put(&record, 1);
+  }
+}
+
+// 结束连续的循环记录，之后写入其他记录
+static void closeTick() {
+  flushRepeats();
+  tickOpen = false;
+}
+
+void startTrace() {
+  head = tail = 0;
+  lostBytes = 0;
+  lostTotal = 0;
+  traceTicks = 0;
+  traceBytes = 0;
+  tickOpen = false;
+  repeatCount = 0;
+  stopping = false;
+  lastMotionId = 0xFF; // 第一次循环结束时总是记录动作状态
+  lastTickTime = millis();
+  traceStart = lastTickTime;
+  lastFlush = lastTickTime;
+
+  // 记录头比缓冲区大，直接输出。回放时用其中的 EEPROM 内容初始化修剪值和姿态
+  uint8_t line[TRACE_LINE_BYTES];
+  line[0] = TRACE_HEADER;
+  for (uint8_t i = 0; i < 4; i++) {
+    line[1 + i] = static_cast<uint8_t>(lastTickTime >> (8 * i));
+  }
+  uint8_t length = 5;
+  for (int addr = 0; addr < TRACE_EEPROM_BYTES; addr++) {
+    line[length++] = EEPROM.read(addr);
+    if (length == TRACE_LINE_BYTES) {
+      writeLine(line, length);
+      length = 0;
+    }
+  }
+  if (length != 0) {
+    writeLine(line, length);
+  }
+  traceBytes = 5 + TRACE_EEPROM_BYTES;
+  tracing = true;
+}
+
+void stopTrace() { stopping = tracing; }
+
+bool traceActive() { return tracing; }
+
+void beginTick() {
+  tickTime = millis();
+  if (!tracing) {
+    return;
+  }
+  unsigned long elapsed = tickTime - lastTickTime;
+  uint16_t delta = elapsed > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(elapsed);
+  lastTickTime = tickTime;
+  traceTicks++;
+
+  if (tickOpen && delta == lastDelta) {
+    if (++repeatCount == TRACE_REPEAT) {
+      flushRepeats();
+    }
+    return;
+  }
+  flushRepeats();
+  if (delta <= TRACE_TICK_MAX) {
+    const uint8_t record = static_cast<uint8_t>(delta);
+    put(&record, 1);
+  } else {
+    const uint8_t record[3] = {TRACE_TICK_LONG, static_cast<uint8_t>(delta),
+                               static_cast<uint8_t>(delta >> 8)};
+    put(record, 3);
+  }
+  lastDelta = delta;
+  tickOpen = true;
+}
+
+unsigned long tickMillis() { return tickTime; }
+
+void endTick() {
+  if (!tracing) {
+    return;
+  }
+  uint8_t id = static_cast<uint8_t>(currentMotionId);
+  uint8_t state = static_cast<uint8_t>(currentMotionState);
+  // 空闲等状态下计数器每次循环都会变化，只在进行中状态记录阶段
+  uint8_t counter = currentMotionState == RobotMotionState::InProgress
+                        ? static_cast<uint8_t>(sharedCounter)
+                        : 0;
+  if (id != lastMotionId || state != lastMotionState || counter != lastCounter) {
+    lastMotionId = id;
+    lastMotionState = state;
+    lastCounter = counter;
+    closeTick();
+    const uint8_t record[4] = {TRACE_CHECKPOINT, id, state, counter};
+    put(record, 4);
+  }
+  if (stopping) {
+    // 本次循环的状态变化已经记录，输出剩余数据
+    closeTick();
+    drain(true);
+    tracing = false;
+    stopping = false;
+    traceStop = millis();
+    printTraceStats();
+    return;
+  }
+  drain(false);
+}
+
+void traceSerialByte(uint8_t value) {
+  if (!tracing) {
+    return;
+  }
+  closeTick();
+  const uint8_t record[2] = {TRACE_SERIAL, value};
+  put(record, 2);
+}
+
+void traceDistance(int distance) {
+  if (!tracing) {
+    return;
+  }
+  closeTick();
+  const uint8_t record[3] = {TRACE_DISTANCE, static_cast<uint8_t>(distance),
+                             static_cast<uint8_t>(distance >> 8)};
+  put(record, 3);
+}
+
+void printTraceStats() {
+  unsigned long seconds = ((tracing ? millis() : traceStop) - traceStart) / 1000;
+  Serial.println(F("Trace stats:"));
+  Serial.print(F("  recording: "));
+  Serial.println(tracing ? F("yes") : F("no"));
+  Serial.print(F("  ticks: "));
+  Serial.println(traceTicks);
+  Serial.print(F("  bytes: "));
+  Serial.println(traceBytes);
+  Serial.print(F("  bytes per second: "));
+  Serial.println(seconds ? traceBytes / seconds : traceBytes);
+  Serial.print(F("  lost bytes: "));
+  Serial.println(lostTotal);
+}
@@ -0,0 +1,53 @@
+#ifndef ROBOT_TRACE_H
+#define ROBOT_TRACE_H
+
+#include <Arduino.h>
+#include "loadResetLog.h"
+
+// 输入记录
+// 记录所有不确定的输入：每次循环开始时的 millis()、读取的串口字节和超声波读数，
+// 以及动作状态的变化（用于回放时校验）。记录先写入一个小的环形缓冲区，
+// 再以 "~" 开头的十六进制行从串口发出，可以和调试输出混在同一个日志里。
+// 主机上的 tools/replay 用这些记录驱动 Linux 版固件，复现现场的状态变化。
+//
+// 每次循环使用同一个时间（tickMillis），保证回放时的时间判断与现场一致。
+
+#define TRACE_BUFFER_SIZE 64   // 环形缓冲区容量，必须是 2 的幂
+#define TRACE_LINE_BYTES 16    // 每行输出的最多字节数
+#define TRACE_FLUSH_MS 200     // 不足一行的数据最多等待的时间
+// 记录头中保存的 EEPROM 字节数：修剪值、反转标志、姿态和复位记录，到复位记录的末尾为止。
+// 之后的动作片段只由 K 指令读写，回放不需要
+#define TRACE_EEPROM_BYTES (IRobot::ResetLog::EEPROM_END)
+
+// 记录格式，每条记录以一个字节开头
+#define TRACE_TICK_MAX 0x3F    // 0x00-0x3F：一次循环，时间前进该毫秒数
+#define TRACE_REPEAT 0x40      // 0x40-0x7F：再重复上一次循环 (低 6 位 + 1) 次
+#define TRACE_TICK_LONG 0x80   // 一次循环，后跟 16 位时间增量
+#define TRACE_SERIAL 0x81      // 后跟读取的串口字节
+#define TRACE_DISTANCE 0x82    // 后跟 16 位超声波读数（毫米）
+#define TRACE_HEADER 0x83      // 后跟 32 位起始时间和 TRACE_EEPROM_BYTES 字节的 EEPROM
+#define TRACE_CHECKPOINT 0x84  // 后跟动作ID、动作状态和计数器低 8 位（仅进行中状态，否则为 0）
+#define TRACE_LOST 0x85        // 后跟 16 位丢失的字节数，之后的记录无法回放
+// 多字节数值均为小端序
+
+// 开始记录，写入记录头
+void startTrace();
+// 停止记录，在本次循环结束时输出剩余数据
+void stopTrace();
+bool traceActive();
+
+// 每次循环开始时调用，确定本次循环使用的时间并记录
+void beginTick();
+// 本次循环开始时的 millis()
+unsigned long tickMillis();
+// 每次循环结束时调用，记录动作状态的变化并输出缓冲区
+void endTick();
+
+// 记录输入
+void traceSerialByte(uint8_t value);
+void traceDistance(int distance);
+
+// 通过串口输出记录统计信息
+void printTraceStats();
+
+#endif // ROBOT_TRACE_H
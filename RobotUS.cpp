@@ -1,9 +1,18 @@
 #include "RobotUS.h"
 #include "IDebug.h"
+#include "RobotEvents.h"
+#include "RobotRate.h"
+#include "RobotTrace.h"
+#include "RobotWatchdog.h"
 
 // 创建超声波传感器对象
 US usSensor;
 
+static USReading latestReading = {0, 0, 0, 0};
+static bool readingsRequested = false; // 上次测距检查之后有动作需要读数
+static bool sampling = false;          // 上次测距检查时也有动作需要读数
+static unsigned long windowStart = 0;  // 下一次读数覆盖的时间起点
+
 void setupUS()
 {
   // 初始化超声波传感器
@@ -14,10 +23,54 @@ void setupUS()
 int getUSDistance()
 {
   // 获取超声波传感器的距离
-  float distance = usSensor.read();                   // 读取距离，单位为毫米
-  int distanceInt = static_cast<int>(distance); // 转换为整数毫米
+  float distance = usSensor.read();                   // 读取距离，单位为厘米（没有回波时为 999）
+  int distanceInt = static_cast<int>(distance) * 10; // 转换为整数毫米，避障阈值都以毫米为单位
   debugF("US Distance: ");
-  debug(distance);
+  debug(distanceInt);
   debuglnF(" mm");
+  traceDistance(distanceInt); // 记录读数，回放时用于复现
   return static_cast<int>(distanceInt); // 返回整数距离
 }
+
+void requestUSReadings()
+{
+  readingsRequested = true;
+}
+
+void updateUS()
+{
+  if (!readingsRequested)
+  {
+    sampling = false;
+    watchdogCheckin(WatchdogTask::Sensing); // 没有需要测距的动作
+    return;
+  }
+  readingsRequested = false;
+  if (!sampling)
+  {
+    sampling = true;
+    windowStart = micros(); // 暂停期间出现的障碍从重新请求读数时起才可能被发现
+  }
+  if (!rateDue(RateTask::Sensing))
+  {
+    return;
+  }
+  latestReading.startMicros = micros();
+  latestReading.sinceMicros = windowStart;
+  windowStart = latestReading.startMicros;
+  latestReading.distance = getUSDistance();
+  latestReading.sequence++;
+  publishEvent(RobotEventType::DistanceMeasured, 0,
+               static_cast<uint16_t>(latestReading.distance));
+  watchdogCheckin(WatchdogTask::Sensing); // 完成一次测距
+}
+
+const USReading &latestUSReading()
+{
+  return latestReading;
+}
+
+unsigned long usObservableMicros()
+{
+  return latestReading.sinceMicros;
+}
@@ -11,4 +11,29 @@ void setupUS();
 // 获取超声波传感器测量的距离
 int getUSDistance();
 
+// 后台测距：有动作需要读数时按测距频率（见 RobotRate.h）测量，每次测距发布
+// DistanceMeasured 事件，动作订阅事件或读取最新的读数，不再各自在阶段中测距
+struct USReading
+{
+  int distance;              // 距离（毫米）
+  uint8_t sequence;          // 每次测距加一，用于判断是否有新读数
+  unsigned long startMicros; // 这次测距开始的时间
+  // 这次测距覆盖的时间起点：上一次测距开始的时间，暂停后的第一次测距为重新请求读数的时间。
+  // 在这之后出现的障碍最早由这次测距发现，反应延迟从这里算起，包括等待测距的时间
+  unsigned long sinceMicros;
+};
+
+// 需要读数的动作每次循环调用；没有动作需要时不测距
+void requestUSReadings();
+
+// 每次循环在动作更新之后、事件分发之前调用，到了测距时间且有动作需要读数时测距一次，
+// 读数在同一次循环内送到订阅者
+void updateUS();
+
+// 最新的读数
+const USReading &latestUSReading();
+
+// 最新读数覆盖的时间起点（见 USReading::sinceMicros），用于统计反应延迟
+unsigned long usObservableMicros();
+
 #endif // ROBOT_US_H
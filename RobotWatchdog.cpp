@@ -0,0 +1,126 @@
+#include "RobotWatchdog.h"
+#include "IDebug.h"
+#include "loadResetLog.h"
+
+#if defined(__AVR__)
+#include <avr/wdt.h>
+#endif
+
+#define WATCHDOG_FIRED_MAGIC 0xA5 // 看门狗中断已触发的标记
+
+IRobot::ResetLog resetLog;
+
+// .noinit 段的变量在复位后保持原值，用于把复位前的状态带到下次启动
+static uint8_t mcusrMirror __attribute__((section(".noinit")));
+static volatile uint8_t currentStage __attribute__((section(".noinit")));
+static volatile uint8_t watchdogFired __attribute__((section(".noinit")));
+
+static IRobot::ResetLog::Cause bootCause = IRobot::ResetLog::Unknown;
+
+static const uint8_t taskCount = static_cast<uint8_t>(WatchdogTask::Count);
+static uint16_t deadlines[taskCount];     // 任务期限，0 表示未注册
+static unsigned long lastCheckin[taskCount];
+static uint16_t missedFeeds = 0;          // 因任务超期而没有喂狗的次数
+
+#if defined(__AVR__)
+// 在 .init3 段执行，早于 C 运行时初始化：保存复位原因并关闭看门狗，
+// 否则看门狗复位后仍以最短周期运行，会导致反复复位
+void captureResetCause() __attribute__((naked, used, section(".init3")));
+void captureResetCause() {
+  mcusrMirror = MCUSR;
+  MCUSR = 0;
+  wdt_disable();
+}
+
+// 看门狗超时先进入中断，记录下正在执行的阶段，下一次超时才复位
+ISR(WDT_vect) { watchdogFired = WATCHDOG_FIRED_MAGIC; }
+#endif
+
+void setupWatchdog() {
+  // 判断复位原因。上电时 .noinit 中是随机值，所以先检查上电和欠压标志；
+  // Optiboot 可能已清除 MCUSR，此时依靠看门狗中断留下的标记
+  uint8_t stage = currentStage;
+#if defined(__AVR__)
+  if (mcusrMirror & _BV(PORF)) {
+    bootCause = IRobot::ResetLog::PowerOn;
+  } else if (mcusrMirror & _BV(BORF)) {
+    bootCause = IRobot::ResetLog::BrownOut;
+  } else if (watchdogFired == WATCHDOG_FIRED_MAGIC || (mcusrMirror & _BV(WDRF))) {
+    bootCause = IRobot::ResetLog::Watchdog;
+  } else if (mcusrMirror & _BV(EXTRF)) {
+    bootCause = IRobot::ResetLog::External;
+  }
+#endif
+  resetLog.record(bootCause, stage);
+  watchdogFired = 0;
+  currentStage = 0xFF;
+
+  if (bootCause == IRobot::ResetLog::Watchdog) {
+    Serial.print(F("Watchdog reset in stage "));
+    Serial.println(stage);
+  }
+
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < taskCount; i++) {
+    lastCheckin[i] = now;
+  }
+
+#if defined(__AVR__)
+  wdt_enable(WDTO_2S);
+  WDTCSR |= _BV(WDIE); // 中断加复位模式
+#endif
+}
+
+void watchdogRegister(WatchdogTask task, uint16_t deadlineMs) {
+  uint8_t index = static_cast<uint8_t>(task);
+  if (index >= taskCount)
+    return;
+  deadlines[index] = deadlineMs;
+  lastCheckin[index] = millis();
+}
+
+void watchdogCheckin(WatchdogTask task) {
+  uint8_t index = static_cast<uint8_t>(task);
+  if (index >= taskCount)
+    return;
+  lastCheckin[index] = millis();
+}
+
+void watchdogStage(WatchdogTask task) {
+  currentStage = static_cast<uint8_t>(task);
+}
+
+void feedWatchdog() {
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (deadlines[i] != 0 && now - lastCheckin[i] > deadlines[i]) {
+      missedFeeds++;
+      return; // 有任务超期，不喂狗
+    }
+  }
+#if defined(__AVR__)
+  wdt_reset();
+  if (watchdogFired == WATCHDOG_FIRED_MAGIC) {
+    // 卡顿已恢复：清除标记并重新启用中断，下次超时仍先记录阶段
+    watchdogFired = 0;
+    WDTCSR |= _BV(WDIE);
+  }
+#endif
+}
+
+void printWatchdogStats() {
+  Serial.print(F("Boot cause: "));
+  Serial.println(static_cast<uint8_t>(bootCause));
+  resetLog.print();
+  Serial.print(F("  missed feeds: "));
+  Serial.println(missedFeeds);
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < taskCount; i++) {
+    if (deadlines[i] == 0)
+      continue;
+    Serial.print(F("  task "));
+    Serial.print(i);
+    Serial.print(F(" last check-in (ms ago): "));
+    Serial.println(now - lastCheckin[i]);
+  }
+}
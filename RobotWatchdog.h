@@ -0,0 +1,46 @@
+#ifndef ROBOT_WATCHDOG_H
+#define ROBOT_WATCHDOG_H
+
+#include <Arduino.h>
+
+// 硬件看门狗与任务监督
+// 每个注册的任务需要在各自的期限内报到，只有所有任务都按时报到时才喂狗。
+// 任务只在自己真正有进展时报到（完成一个动作步骤、完成一次测距、读完串口输入等），
+// 而不是每次轮到它执行时报到，这样任务在循环中空转、不再前进时也会被发现。
+// 某个任务卡住时看门狗先触发中断记录当前执行阶段，随后复位 MCU。
+// 复位原因和复位前的阶段会持久记录在 EEPROM 中。
+
+#define WATCHDOG_DEFAULT_DEADLINE_MS 1000 // 默认任务期限
+#define WATCHDOG_RATE_DEADLINE_MS 2500    // 按频率更新的任务的期限，频率最低 1Hz 时留出两个周期
+
+// 受监督的任务，同时也作为执行阶段的编号
+enum class WatchdogTask : uint8_t
+{
+  Commands,
+  Motion,
+  Servos,
+  Power,
+  Events,
+  Sensing,
+  Count // 任务数量，必须位于最后
+};
+
+// 读取并记录复位原因，然后启用看门狗，在 setup() 末尾调用
+void setupWatchdog();
+
+// 注册任务及其期限（毫秒）
+void watchdogRegister(WatchdogTask task, uint16_t deadlineMs);
+
+// 将当前执行阶段设置为该任务，看门狗复位时记录的就是这个阶段
+void watchdogStage(WatchdogTask task);
+
+// 任务报到：在任务自己的进展点调用
+void watchdogCheckin(WatchdogTask task);
+
+// 所有注册的任务都在期限内报到时喂狗，每次循环调用
+void feedWatchdog();
+
+// 通过串口输出复位统计和任务状态
+void printWatchdogStats();
+
+#endif // ROBOT_WATCHDOG_H
@@ -0,0 +1,240 @@
+#include "ServoPulse.h"
+
+namespace ServoPulse {
+// Timer1 预分频为 8，16MHz（UNO）下每个计数为 0.5 微秒
+#define TICKS_PER_US 2
+#define FRAME_START 0xFF // 正在等待帧结束
+#define GUARD_TICKS 16   // 未绑定通道或帧末尾的最小间隔
+
+// 所有通道的最长脉冲都在一帧内输出完，帧结束的时间不会超出 16 位计数
+static_assert((SERVO_PULSE_MAX_US + GUARD_TICKS / TICKS_PER_US) <= SERVO_PULSE_SLOT_US,
+              "a channel slot must hold the longest pulse");
+static_assert(SERVO_PULSE_FRAME_US * TICKS_PER_US <= 0xFFFFUL,
+              "too many channels: a frame no longer fits in 16-bit Timer1 counts");
+
+static volatile uint8_t *ports[SERVO_PULSE_CHANNELS]; // 通道引脚的输出寄存器
+static uint8_t masks[SERVO_PULSE_CHANNELS];           // 通道引脚的位掩码
+
+// 中断中使用的脉宽（计数值），0 表示不输出
+static volatile uint16_t activeTicks[SERVO_PULSE_CHANNELS];
+// 主程序写入的暂存脉宽，提交后在帧开始时复制到 activeTicks
+static volatile uint16_t pendingTicks[SERVO_PULSE_CHANNELS];
+static volatile bool latchPending = false;
+static volatile bool markPending = false;      // commitMarked() 的目标还没有开始输出
+static volatile bool markLatched = false;      // 标记的目标已开始输出，时间在 markMicros 中
+static volatile unsigned long markMicros = 0;
+#if !defined(__AVR__)
+static unsigned long frameOrigin = 0; // 主机上没有定时器中断，按 begin() 以来的整帧推算输出时间
+#endif
+
+static volatile uint8_t channel = FRAME_START; // 当前输出脉冲的通道
+static volatile uint32_t frames = 0;
+static volatile uint16_t isrMaxTicks = 0;
+static volatile uint16_t isrFrameTicks = 0;
+static uint16_t isrFrameAccum = 0; // 仅在中断中使用
+
+void attach(uint8_t ch, uint8_t pin) {
+  if (ch >= SERVO_PULSE_CHANNELS)
+    return;
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, LOW);
+  ports[ch] = portOutputRegister(digitalPinToPort(pin));
+  masks[ch] = digitalPinToBitMask(pin);
+}
+
+void detach(uint8_t ch) {
+  if (ch >= SERVO_PULSE_CHANNELS)
+    return;
+  noInterrupts();
+  activeTicks[ch] = 0;
+  pendingTicks[ch] = 0;
+  interrupts();
+}
+
+bool attached(uint8_t ch) {
+  if (ch >= SERVO_PULSE_CHANNELS)
+    return false;
+  noInterrupts();
+  bool result = activeTicks[ch] != 0 || pendingTicks[ch] != 0;
+  interrupts();
+  return result;
+}
+
+void begin() {
+#if defined(__AVR__)
+  noInterrupts();
+  TCCR1A = 0;
+  TCCR1B = _BV(CS11); // 预分频 8
+  TCNT1 = 0;
+  OCR1A = GUARD_TICKS;
+  TIFR1 = _BV(OCF1A);   // 清除可能残留的中断标志
+  TIMSK1 |= _BV(OCIE1A); // 启用比较匹配中断
+  interrupts();
+#else
+  frameOrigin = micros();
+#endif
+}
+
+void end() {
+#if defined(__AVR__)
+  noInterrupts();
+  TIMSK1 &= ~_BV(OCIE1A); // 停止比较匹配中断
+  TCCR1B = 0;             // 停止计数
+  interrupts();
+#endif
+  // 拉低可能仍在输出的引脚，下次 begin() 从新的一帧开始
+  for (uint8_t i = 0; i < SERVO_PULSE_CHANNELS; i++) {
+    if (ports[i]) {
+      *ports[i] &= ~masks[i];
+    }
+  }
+  channel = FRAME_START;
+}
+
+uint16_t deciDegreesToMicros(int16_t deciDegrees) {
+  if (deciDegrees < 0)
+    deciDegrees = 0;
+  if (deciDegrees > 1800)
+    deciDegrees = 1800;
+  return SERVO_PULSE_MIN_US +
+         static_cast<uint16_t>(static_cast<uint32_t>(deciDegrees) *
+                               (SERVO_PULSE_MAX_US - SERVO_PULSE_MIN_US) / 1800);
+}
+
+void writeMicroseconds(uint8_t ch, uint16_t us) {
+  if (ch >= SERVO_PULSE_CHANNELS || !ports[ch])
+    return; // 未绑定引脚的通道不输出
+  if (us < SERVO_PULSE_MIN_US)
+    us = SERVO_PULSE_MIN_US;
+  if (us > SERVO_PULSE_MAX_US)
+    us = SERVO_PULSE_MAX_US;
+  // 16 位写入需要关中断，避免中断读到一半的值
+  noInterrupts();
+  pendingTicks[ch] = us * TICKS_PER_US;
+  interrupts();
+}
+
+void writeDeciDegrees(uint8_t ch, int16_t deciDegrees) {
+  writeMicroseconds(ch, deciDegreesToMicros(deciDegrees));
+}
+
+void commit() { latchPending = true; }
+
+void commitMarked() {
+  noInterrupts();
+  latchPending = true;
+  markPending = true;
+  markLatched = false;
+  interrupts();
+#if !defined(__AVR__)
+  // 在下一帧开始时输出
+  const unsigned long now = micros();
+  markMicros = now + (SERVO_PULSE_FRAME_US - (now - frameOrigin) % SERVO_PULSE_FRAME_US) %
+                         SERVO_PULSE_FRAME_US;
+  markPending = false;
+  markLatched = true;
+#endif
+}
+
+bool takeMarkedLatch(unsigned long &us) {
+  noInterrupts();
+  bool latched = markLatched;
+  markLatched = false;
+  us = markMicros;
+  interrupts();
+  return latched;
+}
+
+uint32_t frameCount() {
+  noInterrupts();
+  uint32_t result = frames;
+  interrupts();
+  return result;
+}
+
+uint16_t isrMaxMicros() {
+  noInterrupts();
+  uint16_t result = isrMaxTicks;
+  interrupts();
+  return result / TICKS_PER_US;
+}
+
+uint16_t frameIsrMicros() {
+  noInterrupts();
+  uint16_t result = isrFrameTicks;
+  interrupts();
+  return result / TICKS_PER_US;
+}
+
+void printStats() {
+  Serial.println(F("Servo pulse stats:"));
+  Serial.print(F("  frames: "));
+  Serial.println(frameCount());
+  Serial.print(F("  isr max (us): "));
+  Serial.println(isrMaxMicros());
+  Serial.print(F("  isr per frame (us): "));
+  Serial.println(frameIsrMicros());
+}
+
+#if defined(__AVR__)
+// 比较匹配中断的处理逻辑，强制内联到 ISR 中以避免额外的函数调用开销
+static inline void handleCompare() __attribute__((always_inline));
+static inline void handleCompare() {
+  uint16_t entry = TCNT1;
+
+  if (channel == FRAME_START) {
+    // 新的一帧：重新计时，并在所有引脚均为低电平时锁存新姿态
+    TCNT1 = 0;
+    entry = 0;
+    if (latchPending) {
+      for (uint8_t i = 0; i < SERVO_PULSE_CHANNELS; i++) {
+        activeTicks[i] = pendingTicks[i];
+      }
+      latchPending = false;
+      if (markPending) {
+        markMicros = micros();
+        markPending = false;
+        markLatched = true;
+      }
+    }
+    isrFrameTicks = isrFrameAccum;
+    isrFrameAccum = 0;
+    frames++;
+    channel = 0;
+  } else {
+    // 结束当前通道的脉冲（通道可能在脉冲期间被 detach，所以总是拉低）
+    if (ports[channel]) {
+      *ports[channel] &= ~masks[channel];
+    }
+    channel++;
+  }
+
+  if (channel < SERVO_PULSE_CHANNELS) {
+    uint16_t ticks = activeTicks[channel];
+    if (ticks != 0) {
+      *ports[channel] |= masks[channel];
+      OCR1A = TCNT1 + ticks;
+    } else {
+      OCR1A = TCNT1 + GUARD_TICKS;
+    }
+  } else {
+    // 所有通道输出完毕，等待帧结束
+    const uint16_t frameEnd =
+        static_cast<uint16_t>(SERVO_PULSE_FRAME_US * static_cast<uint32_t>(TICKS_PER_US));
+    uint16_t earliest = TCNT1 + GUARD_TICKS;
+    OCR1A = earliest > frameEnd ? earliest : frameEnd;
+    channel = FRAME_START;
+  }
+
+  uint16_t cost = TCNT1 - entry;
+  isrFrameAccum += cost;
+  if (cost > isrMaxTicks) {
+    isrMaxTicks = cost;
+  }
+}
+#endif
+} // namespace ServoPulse
+
+#if defined(__AVR__)
+ISR(TIMER1_COMPA_vect) { ServoPulse::handleCompare(); }
+#endif
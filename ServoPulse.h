@@ -0,0 +1,57 @@
+#ifndef SERVO_PULSE_H
+#define SERVO_PULSE_H
+
+#include <Arduino.h>
+#include "RobotDefines.h"
+
+// 基于 Timer1 的多路舵机脉冲引擎
+// 所有通道在一帧内依次输出脉冲，由同一个比较匹配中断驱动。
+// 写入的目标值先暂存，调用 commit() 后在下一帧开始时一次性生效，
+// 保证同一姿态的所有舵机在同一帧内改变。
+// 帧周期按通道数确定：每个通道留出一个最长脉冲的时间，不足 20ms 时取 20ms。
+// 8 个舵机为 20ms（50Hz），12 个舵机为 30ms（约 33Hz），帧长度固定，不随角度变化。
+// 一帧必须能用 16 位的 Timer1 计数表示，因此最多 13 个通道（编译期检查）。
+// 注意：占用 Timer1，不能与 Arduino Servo 库同时使用。
+namespace ServoPulse {
+#define SERVO_PULSE_CHANNELS ROBOT_SERVOS // 通道数量，每个舵机一个
+#define SERVO_PULSE_MIN_US 544     // 0 度对应的脉宽（与 Servo 库一致）
+#define SERVO_PULSE_MAX_US 2400    // 180 度对应的脉宽
+#define SERVO_PULSE_SLOT_US 2500UL // 每个通道在一帧中占用的最长时间（最长脉冲加上中断的余量）
+#define SERVO_PULSE_FRAME_US                                         \
+    (SERVO_PULSE_CHANNELS * SERVO_PULSE_SLOT_US > 20000UL           \
+         ? SERVO_PULSE_CHANNELS * SERVO_PULSE_SLOT_US               \
+         : 20000UL) // 帧周期（微秒）
+
+    // 将通道绑定到引脚，绑定后保持不输出脉冲，直到写入目标并提交
+    void attach(uint8_t channel, uint8_t pin);
+    // 停止通道输出
+    void detach(uint8_t channel);
+    bool attached(uint8_t channel);
+
+    // 启动定时器
+    void begin();
+    // 停止定时器并拉低所有引脚，用于低功耗
+    void end();
+
+    // 暂存目标脉宽（微秒）
+    void writeMicroseconds(uint8_t channel, uint16_t us);
+    // 暂存目标角度（0.1 度，0-1800）
+    void writeDeciDegrees(uint8_t channel, int16_t deciDegrees);
+    // 提交暂存的目标，在下一帧开始时生效
+    void commit();
+    // 与 commit() 相同，并记录这些目标开始输出的时间，用于测量反应延迟
+    void commitMarked();
+    // commitMarked() 提交的目标已经开始输出时返回 true 并给出当时的 micros()，每次标记只返回一次
+    bool takeMarkedLatch(unsigned long &us);
+
+    // 0.1 度与脉宽之间的换算
+    uint16_t deciDegreesToMicros(int16_t deciDegrees);
+
+    // 统计信息
+    uint32_t frameCount();      // 已输出的帧数
+    uint16_t isrMaxMicros();    // 单次中断的最长耗时（微秒）
+    uint16_t frameIsrMicros();  // 上一帧内中断的总耗时（微秒）
+    void printStats();
+} // namespace ServoPulse
+
+#endif // SERVO_PULSE_H
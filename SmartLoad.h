@@ -1,19 +1,57 @@
 #pragma once
 /*
-从 EEPROM中读取和写入快速加载标志的代码，从而实现辨别是否可以快速加载的功能。
+启动握手：上电后在很短的窗口内监听串口，若收到保持字符则停在启动阶段，
+不驱动任何舵机，从而为重新烧录程序或排查问题提供窗口。
 
-当机器开始工作时，禁用快速加载，使得重启时能够提供覆盖程序的窗口。
+主机在复位后持续发送保持字符即可让机器人停住，之后发送回车继续启动。
+保持期间超过 BOOT_HOLD_MS 没有再收到保持字符时自动继续启动，
+误收到的保持字符或拔掉的主机不会让机器人一直停在启动阶段。
+在窗口内发送记录字符则从第一次循环开始记录输入，用于在主机上回放。
+这取代了原先依赖 EEPROM 快速加载标志并等待 4 秒的做法，
+也避免了每次循环都写 EEPROM。
 */
 
-#include <EEPROM.h>
-#define EEPROM_FASTLOAD_MAGIC 0xD2  // EEPROM地址(用于设置是否快速启动)
-#define EEPROM_FASTLOAD_OFFSET 6   // EEPROM偏移量(用于设置是否快速启动)
+#include <Arduino.h>
 
-inline bool getEEPROMFastLoad() {
-  // 获取EEPROM快速加载标志
-  return EEPROM.read(EEPROM_FASTLOAD_OFFSET) == EEPROM_FASTLOAD_MAGIC;
-}
-inline void setEEPROMFastLoad(bool enable) {
-  // 设置EEPROM快速加载标志
-  EEPROM.write(EEPROM_FASTLOAD_OFFSET, enable ? EEPROM_FASTLOAD_MAGIC : 0);
+#define BOOT_HANDSHAKE_MS 50    // 启动握手窗口（毫秒）
+#define BOOT_HOLD_CHAR '!'      // 保持在启动阶段的字符
+#define BOOT_RELEASE_CHAR '\r'  // 结束保持、继续启动的字符
+#define BOOT_TRACE_CHAR 'X'     // 启动后记录输入的字符
+#define BOOT_HOLD_MS 10000      // 保持的期限（毫秒），每收到一个保持字符重新计时
+
+// 握手结果
+#define BOOT_HELD 0x01   // 曾经被主机保持
+#define BOOT_TRACE 0x02  // 主机请求记录输入
+
+// 等待启动握手，返回握手结果
+inline uint8_t bootHandshake() {
+  Serial.println(F("Boot"));  // 通知主机可以发送保持字符
+  uint8_t result = 0;
+  unsigned long start = millis();
+  while (millis() - start < BOOT_HANDSHAKE_MS) {
+    if (Serial.available() == 0) {
+      continue;
+    }
+    char c = Serial.read();
+    if (c == BOOT_TRACE_CHAR) {
+      result |= BOOT_TRACE;
+    } else if (c == BOOT_HOLD_CHAR) {
+      Serial.println(F("Boot held, send CR to continue."));
+      unsigned long held = millis();
+      while (millis() - held < BOOT_HOLD_MS) {
+        if (Serial.available() == 0) {
+          continue;
+        }
+        c = Serial.read();
+        if (c == BOOT_RELEASE_CHAR) {
+          break;
+        }
+        if (c == BOOT_HOLD_CHAR) {
+          held = millis();
+        }
+      }
+      return result | BOOT_HELD;
+    }
+  }
+  return result;
 }
\ No newline at end of file
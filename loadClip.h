@@ -0,0 +1,54 @@
+#pragma once
+
+#include <EEPROM.h>
+#ifdef VSCODE
+#include <cstdint>
+#endif
+#include <Arduino.h>
+#include "loadResetLog.h"
+
+namespace IRobot {
+
+// 在 EEPROM 中保存一个录制的动作片段，片段内容由调用者提供的缓冲区存放
+class ClipStore {
+private:
+    static constexpr uint16_t EEPROM_MAGIC = 0xabcd;
+    static constexpr uint16_t EEPROM_MAGIC_ADDR = ResetLog::EEPROM_END;   // 魔数存储位置，紧跟在 ResetLog 之后
+    static constexpr uint16_t EEPROM_LENGTH_ADDR = EEPROM_MAGIC_ADDR + 2; // 片段长度
+    static constexpr uint16_t EEPROM_OFFSET = EEPROM_MAGIC_ADDR + 4;      // 数据存储位置
+
+public:
+    static constexpr uint16_t CAPACITY = E2END + 1 - EEPROM_OFFSET;
+
+    // 读取保存的片段，返回长度，没有保存的片段或缓冲区不够时返回 0
+    uint16_t load(uint8_t *data, uint16_t size) const {
+        uint16_t magic = (EEPROM.read(EEPROM_MAGIC_ADDR) << 8) | EEPROM.read(EEPROM_MAGIC_ADDR + 1);
+        if (magic != EEPROM_MAGIC) {
+            return 0;
+        }
+        uint16_t length = (EEPROM.read(EEPROM_LENGTH_ADDR) << 8) | EEPROM.read(EEPROM_LENGTH_ADDR + 1);
+        if (length > size || length > CAPACITY) {
+            return 0;
+        }
+        for (uint16_t i = 0; i < length; i++) {
+            data[i] = EEPROM.read(i + EEPROM_OFFSET);
+        }
+        return length;
+    }
+
+    // 使用 update 只写入变化的字节，重复保存同一片段不消耗 EEPROM 寿命
+    void store(const uint8_t *data, uint16_t length) const {
+        if (length > CAPACITY) {
+            return;
+        }
+        EEPROM.update(EEPROM_MAGIC_ADDR, EEPROM_MAGIC >> 8);
+        EEPROM.update(EEPROM_MAGIC_ADDR + 1, EEPROM_MAGIC & 0xFF);
+        EEPROM.update(EEPROM_LENGTH_ADDR, length >> 8);
+        EEPROM.update(EEPROM_LENGTH_ADDR + 1, length & 0xFF);
+        for (uint16_t i = 0; i < length; i++) {
+            EEPROM.update(i + EEPROM_OFFSET, data[i]);
+        }
+    }
+};
+
+} // namespace IRobot
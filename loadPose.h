@@ -0,0 +1,76 @@
+#pragma once
+
+#include <EEPROM.h>
+#ifdef VSCODE
+#include <cstdint>
+#endif
+#include <Arduino.h>
+#include "IDebug.h"
+#include "RobotDefines.h"
+#include "loadTrim.h"
+
+namespace IRobot {
+
+// 记录最后一次稳定姿态（各舵机的输出角度），上电时从该姿态平缓启动
+class ServoPose {
+private:
+    static constexpr uint16_t EEPROM_MAGIC = 0xabcd;
+    // 为 ServoPose 分配独立的 EEPROM 存储区域
+    static constexpr uint8_t EEPROM_MAGIC_ADDR = ServoTrim::EEPROM_END; // 魔数存储位置，紧跟在 ServoTrim 之后
+    static constexpr uint8_t EEPROM_OFFSET = EEPROM_MAGIC_ADDR + 2;     // 数据存储位置
+    uint8_t pose[ROBOT_SERVOS];
+
+public:
+    // 存储区域的末尾，之后是 ResetLog 的区域；8 个舵机时为 50
+    static constexpr uint8_t EEPROM_END = EEPROM_OFFSET + ROBOT_SERVOS;
+
+    ServoPose() {
+        for (int i = 0; i < ROBOT_SERVOS; i++) {
+            pose[i] = 90; // 默认所有舵机在中心位置
+        }
+        load(); // 构造时自动加载
+    }
+
+    void load() {
+        uint16_t magic = (EEPROM.read(EEPROM_MAGIC_ADDR) << 8) | EEPROM.read(EEPROM_MAGIC_ADDR + 1);
+        if (magic == EEPROM_MAGIC) {
+            for (int i = 0; i < ROBOT_SERVOS; i++) {
+                uint8_t val = EEPROM.read(i + EEPROM_OFFSET);
+                pose[i] = val <= 180 ? val : 90;
+            }
+        } else {
+            store();
+        }
+    }
+
+    // 使用 update 只写入变化的字节，姿态未变时不消耗 EEPROM 寿命
+    void store() const {
+        EEPROM.update(EEPROM_MAGIC_ADDR, EEPROM_MAGIC >> 8);
+        EEPROM.update(EEPROM_MAGIC_ADDR + 1, EEPROM_MAGIC & 0xFF);
+        for (int i = 0; i < ROBOT_SERVOS; i++) {
+            EEPROM.update(i + EEPROM_OFFSET, pose[i]);
+        }
+    }
+
+    void set(int index, int angle) {
+        if (index >= 0 && index < ROBOT_SERVOS && angle >= 0 && angle <= 180) {
+            pose[index] = static_cast<uint8_t>(angle);
+        }
+    }
+
+    int get(int index) const {
+        return static_cast<int>(pose[index]);
+    }
+
+    void print() const {
+        Serial.println(F("Stored Servo Pose:"));
+        for (int i = 0; i < ROBOT_SERVOS; i++) {
+            debugF("Servo ");
+            debug(i);
+            debugF(": ");
+            debugln(get(i));
+        }
+    }
+};
+
+} // namespace IRobot
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <EEPROM.h>
+#ifdef VSCODE
+#include <cstdint>
+#endif
+#include <Arduino.h>
+#include "IDebug.h"
+#include "loadPose.h"
+
+namespace IRobot {
+
+// 复位原因计数，持久保存在 EEPROM 中，用于统计现场死机和复位
+class ResetLog {
+public:
+    enum Cause : uint8_t {
+        PowerOn,
+        External,
+        BrownOut,
+        Watchdog,
+        Unknown,
+        CauseCount
+    };
+
+private:
+    static constexpr uint16_t EEPROM_MAGIC = 0xabcd;
+    // 为 ResetLog 分配独立的 EEPROM 存储区域
+    static constexpr uint8_t EEPROM_MAGIC_ADDR = ServoPose::EEPROM_END; // 魔数存储位置，紧跟在 ServoPose 之后
+    static constexpr uint8_t EEPROM_STAGE_ADDR = EEPROM_MAGIC_ADDR + 2; // 最后一次看门狗复位时的执行阶段
+    static constexpr uint8_t EEPROM_OFFSET = EEPROM_MAGIC_ADDR + 3;     // 计数存储位置
+    uint16_t counts[CauseCount] = {};
+    uint8_t lastStage = 0xFF; // 0xFF 表示从未发生看门狗复位
+
+public:
+    // 存储区域的末尾（留有 1 字节空余），之后是 ClipStore 的区域；8 个舵机时为 64
+    static constexpr uint8_t EEPROM_END = EEPROM_OFFSET + 2 * CauseCount + 1;
+
+    ResetLog() {
+        load(); // 构造时自动加载
+    }
+
+    void load() {
+        uint16_t magic = (EEPROM.read(EEPROM_MAGIC_ADDR) << 8) | EEPROM.read(EEPROM_MAGIC_ADDR + 1);
+        if (magic == EEPROM_MAGIC) {
+            lastStage = EEPROM.read(EEPROM_STAGE_ADDR);
+            for (int i = 0; i < CauseCount; i++) {
+                counts[i] = (EEPROM.read(i * 2 + EEPROM_OFFSET) << 8) |
+                            EEPROM.read(i * 2 + EEPROM_OFFSET + 1);
+            }
+        } else {
+            store(); // 默认值为0，直接存储
+        }
+    }
+
+    void store() const {
+        EEPROM.update(EEPROM_MAGIC_ADDR, EEPROM_MAGIC >> 8);
+        EEPROM.update(EEPROM_MAGIC_ADDR + 1, EEPROM_MAGIC & 0xFF);
+        EEPROM.update(EEPROM_STAGE_ADDR, lastStage);
+        for (int i = 0; i < CauseCount; i++) {
+            EEPROM.update(i * 2 + EEPROM_OFFSET, counts[i] >> 8);
+            EEPROM.update(i * 2 + EEPROM_OFFSET + 1, counts[i] & 0xFF);
+        }
+    }
+
+    // 记录一次复位，看门狗复位时同时记录复位前的执行阶段
+    void record(Cause cause, uint8_t stage) {
+        if (cause >= CauseCount)
+            return;
+        if (counts[cause] != 0xFFFF)
+            counts[cause]++;
+        if (cause == Watchdog)
+            lastStage = stage;
+        store();
+    }
+
+    uint16_t get(Cause cause) const {
+        return cause < CauseCount ? counts[cause] : 0;
+    }
+
+    uint8_t getLastStage() const {
+        return lastStage;
+    }
+
+    void print() const {
+        Serial.println(F("Reset counts:"));
+        Serial.print(F("  power on: "));
+        Serial.println(counts[PowerOn]);
+        Serial.print(F("  external: "));
+        Serial.println(counts[External]);
+        Serial.print(F("  brown out: "));
+        Serial.println(counts[BrownOut]);
+        Serial.print(F("  watchdog: "));
+        Serial.println(counts[Watchdog]);
+        Serial.print(F("  unknown: "));
+        Serial.println(counts[Unknown]);
+        Serial.print(F("  last watchdog stage: "));
+        Serial.println(lastStage);
+    }
+};
+
+} // namespace IRobot
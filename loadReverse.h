@@ -6,6 +6,7 @@
 #endif
 #include <Arduino.h>
 #include "IDebug.h"
+#include "RobotDefines.h"
 
 namespace IRobot {
 
@@ -15,8 +16,9 @@ private:
     // 为 ServoReverse 分配独立的 EEPROM 存储区域
     static constexpr uint8_t EEPROM_MAGIC_ADDR = 2; // 魔数存储位置
     static constexpr uint8_t EEPROM_OFFSET = 4;     // 数据存储位置
-    // 用一个字节的每一位表示一个舵机的反转标志
-    uint8_t reverse = 0;
+    // 每一位表示一个舵机的反转标志，8 个舵机时占一个字节
+    ServoMask reverse = 0;
+    static_assert(EEPROM_OFFSET + sizeof(ServoMask) <= 20, "reverse flags overlap the trim values");
 
 public:
     ServoReverse() {
@@ -24,36 +26,40 @@ public:
     }    void load() {
         uint16_t magic = (EEPROM.read(EEPROM_MAGIC_ADDR) << 8) | EEPROM.read(EEPROM_MAGIC_ADDR + 1);
         if (magic == EEPROM_MAGIC) {
-            uint8_t val = EEPROM.read(EEPROM_OFFSET);
-            reverse = val;
+            reverse = 0;
+            for (uint8_t i = 0; i < sizeof(reverse); i++) {
+                reverse |= static_cast<ServoMask>(EEPROM.read(EEPROM_OFFSET + i)) << (i * 8);
+            }
         } else {
             store(); // 默认值为0，直接存储
         }
     }    void store() const {
         EEPROM.write(EEPROM_MAGIC_ADDR, EEPROM_MAGIC >> 8);
         EEPROM.write(EEPROM_MAGIC_ADDR + 1, EEPROM_MAGIC & 0xFF);
-        EEPROM.write(EEPROM_OFFSET, reverse);
+        for (uint8_t i = 0; i < sizeof(reverse); i++) {
+            EEPROM.write(EEPROM_OFFSET + i, static_cast<uint8_t>(reverse >> (i * 8)));
+        }
     }
 
     void set(int index, bool isReverse) {
-        if (index >= 0 && index < 8) {
+        if (index >= 0 && index < ROBOT_SERVOS) {
             if (isReverse)
-                reverse |= (1 << index);
+                reverse |= BodyLayout::bit(index);
             else
-                reverse &= ~(1 << index);
+                reverse &= ~BodyLayout::bit(index);
         }
     }
 
     bool get(int index) const {
-        if (index >= 0 && index < 8) {
-            return (reverse & (1 << index)) != 0;
+        if (index >= 0 && index < ROBOT_SERVOS) {
+            return (reverse & BodyLayout::bit(index)) != 0;
         }
         return false;
     }
 
     void print() const {
         Serial.println(F("Current Servo Reverse Flags:"));
-        for (int i = 0; i < 8; i++) {
+        for (int i = 0; i < ROBOT_SERVOS; i++) {
             debugF("Servo ");
             debug(i);
             debugF(": ");
@@ -6,6 +6,7 @@
 #endif
 #include <Arduino.h>
 #include "IDebug.h"
+#include "RobotDefines.h"
 
 namespace IRobot {
 
@@ -15,7 +16,18 @@ private:
     // 为 ServoTrim 分配独立的 EEPROM 存储区域
     static constexpr uint8_t EEPROM_MAGIC_ADDR = 2; // 魔数存储位置，与 ServoReverse 不同
     static constexpr uint8_t EEPROM_OFFSET = 20;     // 数据存储位置
-    int8_t trim[8] = {-20,10,0,0,0,0,10,0}; // 默认值，8个舵机的trim值
+    static constexpr uint8_t EEPROM_TURN_OFFSET = EEPROM_OFFSET + 2 * ROBOT_SERVOS; // 转向标定表，紧跟在修剪值之后
+    int8_t trim[ROBOT_SERVOS] = {-20,10,0,0,0,0,10,0}; // 默认值，其余舵机为 0
+
+public:
+    // 转向标定表：左转、右转在两个髋关节幅度下每个周期转过的角度（0.5 度）
+    static constexpr uint8_t TURN_POINTS = 2;
+    static constexpr uint8_t TURN_AMPLITUDE_STEP = 20; // 标定点的幅度为 20、40 度
+    // 存储区域的末尾，之后是 ServoPose 的区域；8 个舵机时为 40
+    static constexpr uint8_t EEPROM_END = EEPROM_TURN_OFFSET + 2 * TURN_POINTS;
+
+private:
+    uint8_t turn[2 * TURN_POINTS] = {36, 72, 36, 72}; // 默认每个周期 18 度（幅度 20 度时）
 
 public:
     ServoTrim() {
@@ -23,7 +35,7 @@ public:
     }    void load() {
         uint16_t magic = (EEPROM.read(EEPROM_MAGIC_ADDR) << 8) | EEPROM.read(EEPROM_MAGIC_ADDR + 1);
         if (magic == EEPROM_MAGIC) {
-            for (int i = 0; i < 8; i++) {
+            for (int i = 0; i < ROBOT_SERVOS; i++) {
                 int16_t val = (EEPROM.read(i * 2 + EEPROM_OFFSET) << 8) |
                               EEPROM.read(i * 2 + EEPROM_OFFSET + 1);
                 if (val >= -90 && val <= 90) {
@@ -36,6 +48,13 @@ public:
                     debugF(", resetting to default (0).");
                 }
             }
+            for (int i = 0; i < 2 * TURN_POINTS; i++) {
+                uint8_t val = EEPROM.read(i + EEPROM_TURN_OFFSET);
+                // 旧版本没有保存标定表（读到 0xFF），保持默认值
+                if (val != 0 && val != 0xFF) {
+                    turn[i] = val;
+                }
+            }
         } else {
             // 第一次运行，写入魔术数并保存默认值
             store(); // 默认值为0，直接存储
@@ -44,14 +63,17 @@ public:
         EEPROM.write(EEPROM_MAGIC_ADDR, EEPROM_MAGIC >> 8);
         EEPROM.write(EEPROM_MAGIC_ADDR + 1, EEPROM_MAGIC & 0xFF);
 
-        for (int i = 0; i < 8; i++) {
+        for (int i = 0; i < ROBOT_SERVOS; i++) {
             EEPROM.write(i * 2 + EEPROM_OFFSET, trim[i] >> 8);
             EEPROM.write(i * 2 + EEPROM_OFFSET + 1, trim[i] & 0xFF);
         }
+        for (int i = 0; i < 2 * TURN_POINTS; i++) {
+            EEPROM.write(i + EEPROM_TURN_OFFSET, turn[i]);
+        }
     }
 
     void set(int index, int value) {
-        if (index >= 0 && index < 8 && value >= -90 && value <= 90) {
+        if (index >= 0 && index < ROBOT_SERVOS && value >= -90 && value <= 90) {
             trim[index] = static_cast<uint8_t>(value);
         }
     }
@@ -60,15 +82,34 @@ public:
         return static_cast<int>(trim[index]);
     }
 
+    // 第 point 个标定点（幅度为 (point + 1) * TURN_AMPLITUDE_STEP）每个周期转过的角度（0.5 度）
+    void setTurn(bool left, int point, int halfDegrees) {
+        if (point >= 0 && point < TURN_POINTS && halfDegrees > 0 && halfDegrees < 0xFF) {
+            turn[(left ? 0 : TURN_POINTS) + point] = static_cast<uint8_t>(halfDegrees);
+        }
+    }
+
+    uint8_t getTurn(bool left, int point) const {
+        return turn[(left ? 0 : TURN_POINTS) + point];
+    }
+
     void print() const {
         Serial.println(F("Current Servo Trims:"));
-        for (int i = 0; i < 8; i++) {
+        for (int i = 0; i < ROBOT_SERVOS; i++) {
             debugF("Servo ");
             debug(i);
             debugF(": ");
             debugln(get(i));
         }
+        Serial.println(F("Turn calibration (deg/cycle at amplitude):"));
+        for (int i = 0; i < 2 * TURN_POINTS; i++) {
+            Serial.print(i < TURN_POINTS ? F("  L ") : F("  R "));
+            Serial.print((i % TURN_POINTS + 1) * TURN_AMPLITUDE_STEP);
+            Serial.print(F(": "));
+            Serial.print(turn[i] / 2);
+            Serial.println(turn[i] % 2 ? F(".5") : F(""));
+        }
     }
 };
 
-} // namespace IRobot
\ No newline at end of file
+} // namespace IRobot
@@ -8,6 +8,12 @@
 #include "RobotMotion.h"
 #include "RobotCommands.h"
 #include "RobotOLED.h"
+#include "RobotMemory.h"
+#include "RobotPower.h"
+#include "RobotWatchdog.h"
+#include "RobotEvents.h"
+#include "RobotTrace.h"
+#include "RobotRate.h"
 
 #ifdef VSCODE
 #include <cstdint>
@@ -16,50 +22,82 @@
 //-=================== loader ========================
 IRobot::ServoTrim trimLoader;
 IRobot::ServoReverse reverseLoader;
+IRobot::ServoPose poseLoader;
 
 //-=================== 主程序 ========================
 
 void setup()
 {
   Serial.begin(9600); // 初始化串口通信
-  delay(100);
+  // 短暂的启动握手，为重新烧录提供窗口
+  uint8_t boot = bootHandshake();
   debuglnF("Robot Simple Setup Start...");
 
   // 初始化 us传感器
   setupUS();
-  debuglnF("US Sensor setup complete.");
 
-  // 设置舵机修剪
-  trimLoader.load();  // 加载修剪值
-  trimLoader.print(); // 再次打印以确认加载成功
-  trimLoader.store(); // 保存修剪值到EEPROM
+  // 订阅事件：动作请求和测距读数最先处理，表情显示优先于调试日志
+  setupFaceEvents();
+  setupMotionEvents();
+  setupEventLog();
 
-  // 设置舵机反向
-  reverseLoader.load();  // 加载反向值
-  reverseLoader.print(); // 打印当前反向值
-  reverseLoader.store(); // 保存反向值到EEPROM
+  // 修剪值和反向值已在 trimLoader / reverseLoader 构造时从 EEPROM 加载，
+  // 这里不再重复加载和写回。可用 Q C 指令查看当前值。
 
-  if (getEEPROMFastLoad())
-  {
-    Serial.println(F("Fast Reload"));
-  }
-  else
-  {
-    Serial.println(F("Slow Load"));
-    delay(4000);
-  }
-  setEEPROMFastLoad(true); // 设置快速加载标志
+  // 注册受监督的任务并启用看门狗
+  watchdogRegister(WatchdogTask::Commands, WATCHDOG_DEFAULT_DEADLINE_MS);
+  watchdogRegister(WatchdogTask::Motion, WATCHDOG_DEFAULT_DEADLINE_MS);
+  watchdogRegister(WatchdogTask::Servos, WATCHDOG_RATE_DEADLINE_MS);
+  watchdogRegister(WatchdogTask::Power, WATCHDOG_DEFAULT_DEADLINE_MS);
+  watchdogRegister(WatchdogTask::Events, WATCHDOG_DEFAULT_DEADLINE_MS);
+  watchdogRegister(WatchdogTask::Sensing, WATCHDOG_RATE_DEADLINE_MS);
+  setupWatchdog();
 
-  showFace("happy"); // 显示默认表情
+  // 报告从上电到可以开始动作的时间
+  Serial.print(F("Ready in "));
+  Serial.print(micros());
+  Serial.println(F(" us"));
+
+  // 主机在启动握手时请求了记录，从第一次循环开始记录输入
+  if (boot & BOOT_TRACE) {
+    startTrace();
+  }
 }
 
 void loop()
 {
-  setEEPROMFastLoad(false); // 禁用快速加载，确保重启时可以覆盖程序
-  handleCommands();         // 处理串口命令
+  beginTick(); // 确定本次循环使用的时间
 
+  watchdogStage(WatchdogTask::Commands);
+  handleCommands(); // 处理串口命令
+
+  // 各子系统按各自的频率更新（见 RobotRate.h），只使用其他子系统最新的数据
+  watchdogStage(WatchdogTask::Motion);
   SyncMovingState(); // 同步运动状态
   UpdateMotion();    // 更新运动状态
+
+  watchdogStage(WatchdogTask::Servos);
+  if (rateDue(RateTask::Servos)) {
+    updateServoModel(); // 推进舵机位置估计并启动被推迟的舵机
+    watchdogCheckin(WatchdogTask::Servos); // 完成一次舵机模型更新
+  }
+
+  watchdogStage(WatchdogTask::Sensing);
+  updateUS(); // 有动作需要时按测距频率测距，读数随后作为事件分发
+
+  watchdogStage(WatchdogTask::Events);
+  dispatchEvents(); // 分发表情、日志等事件，每次循环有数量上限
+  updateDisplay();  // 按显示频率绘制最新的表情
+
+  updateMemoryStats(); // 记录最小空闲内存
+
+  watchdogStage(WatchdogTask::Power);
+  updatePower(); // 空闲时断开舵机并睡眠，直到串口或定时器唤醒
+  watchdogCheckin(WatchdogTask::Power); // 完成一次空闲和睡眠判断
+
+  feedWatchdog(); // 所有任务按时报到才喂狗
+
+  endTick(); // 记录动作状态的变化并输出记录
 }
 
 
@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+# 通过串口把动作片段分块上传到机器人，边上传边回放
+#
+# 用法：tools/clip_upload.py <串口> <片段文件> [速度百分比]
+# 片段文件为 K D 指令输出的 `#` 开头的十六进制行。依赖 pyserial。
+# 机器人每收到一块回复 ACK <序号> <剩余空间>，剩余空间不够下一块时等待回放腾出空间；
+# 校验失败或序号不对时回复 NAK <期望的序号> <原因>，从期望的序号重发。
+
+import sys
+import time
+
+import serial
+
+CHUNK = 16       # 与固件的 CLIP_CHUNK_MAX 一致
+PREBUFFER = 4    # 开始回放前先上传的块数
+NAK_FULL = 3     # ClipChunkResult::Full
+
+
+def crc8(seq, data):
+    crc = 0
+    for value in bytes([seq]) + data:
+        crc ^= value
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def read_clip(path):
+    with open(path) as f:
+        return bytes.fromhex(''.join(line.strip()[1:] for line in f if line.startswith('#')))
+
+
+def wait_reply(port, timeout=1.0):
+    deadline = time.time() + timeout
+    while time.time() < deadline:
+        line = port.readline().decode(errors='replace').strip()
+        if line.startswith('ACK') or line.startswith('NAK'):
+            return line.split()
+    return None
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit('usage: clip_upload.py <port> <clip file> [speed]')
+    clip = read_clip(sys.argv[2])
+    speed = sys.argv[3] if len(sys.argv) > 3 else '100'
+    chunks = [clip[i:i + CHUNK] for i in range(0, len(clip), CHUNK)]
+
+    port = serial.Serial(sys.argv[1], 9600, timeout=0.1)
+    time.sleep(2)  # 打开串口会复位机器人
+    port.reset_input_buffer()
+
+    port.write(b'K U\r')
+    reply = wait_reply(port)
+    if not reply or reply[0] != 'ACK':
+        sys.exit('robot did not accept the upload')
+    free = int(reply[2])
+
+    start = time.time()
+    seq = 0
+    retries = 0
+    playing = False
+    while seq < len(chunks):
+        if not playing and (seq == PREBUFFER or seq == len(chunks) - 1):
+            port.write(('K P %s\r' % speed).encode())
+            playing = True
+        data = chunks[seq]
+        if len(data) > free:
+            time.sleep(0.05)  # 等回放腾出空间后再试，仍然不够时机器人回复 NAK
+            free = CHUNK
+            continue
+        port.write(('K C %d %s %02X\r' % (seq & 0xFF, data.hex().upper(), crc8(seq & 0xFF, data))).encode())
+        reply = wait_reply(port)
+        if reply and reply[0] == 'ACK':
+            free = int(reply[2])
+            seq += 1
+            continue
+        retries += 1
+        if reply and reply[0] == 'NAK':
+            if int(reply[2]) == NAK_FULL:
+                free = 0
+            # 从机器人期望的序号继续，序号只有 8 位
+            expected = int(reply[1])
+            seq = seq - ((seq - expected) & 0xFF)
+    port.write(b'K F\r')
+
+    elapsed = time.time() - start
+    print('uploaded %d bytes in %.2f s (%.0f bytes/s), %d retries' %
+          (len(clip), elapsed, len(clip) / elapsed, retries))
+
+
+if __name__ == '__main__':
+    main()
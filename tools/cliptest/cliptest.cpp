@@ -0,0 +1,257 @@
+// 动作片段的往返测试
+// 在 Linux 上运行固件，按给定的时间间隔录制舵机目标，保存到 EEPROM 后按文档中的编码解码，
+// 检查每个目标的时间和角度，再用固件自己的回放按原速播放一遍，检查回放时长。
+// 间隔覆盖短等待和长等待的边界（63、64、65 个时间单位等）。
+// 另外检查分块上传：第一块之前序号 255 不被当作重发，上传的片段可以从头重复回放。
+//
+// 用法：cliptest [-v]
+//   -v  输出固件的串口内容
+// 全部通过时返回 0。
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "Host.h"
+
+#include "RobotClip.h"
+#include "RobotTrace.h"
+#include "loadClip.h"
+
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+struct Target {
+  unsigned long time; // 相对录制开始的时间（毫秒）
+  uint8_t id;
+  int angle;
+};
+
+static const unsigned long HOLD_MS = 100; // 最后一个目标之后到停止录制的时间
+
+// 时间前进 ms 毫秒，固件在每次循环开始时读取时间
+static void advance(unsigned long ms) {
+  clockMs += ms;
+  beginTick();
+}
+
+// 按 RobotClip.h 中的编码解码片段，遇到无法解码的记录时返回 false
+static bool decode(const uint8_t *clip, uint16_t length, std::vector<Target> &targets,
+                   unsigned long &duration) {
+  int angles[ROBOT_SERVOS];
+  for (int &angle : angles) angle = -1;
+  unsigned long time = 0;
+  uint16_t pos = 0;
+  while (pos < length) {
+    uint8_t code = clip[pos];
+    if (code == CLIP_WAIT_LONG) {
+      if (pos + 3 > length) return false;
+      time += clip[pos + 1] | (clip[pos + 2] << 8);
+      pos += 3;
+    } else if (code >= CLIP_WAIT) {
+      time += ((code & 0x3F) + 1) * CLIP_TIME_UNIT_MS;
+      pos += 1;
+    } else if (code >= CLIP_ABSOLUTE) {
+      uint8_t id = code - CLIP_ABSOLUTE;
+      if (id >= ROBOT_SERVOS || pos + 2 > length) return false;
+      angles[id] = clip[pos + 1];
+      targets.push_back({time, id, angles[id]});
+      pos += 2;
+    } else {
+      uint8_t id = code >> 4;
+      int diff = code & 0x0F;
+      if (diff & 0x08) diff -= 16;
+      if (angles[id] < 0) return false;
+      angles[id] += diff;
+      targets.push_back({time, id, angles[id]});
+      pos += 1;
+    }
+  }
+  duration = time;
+  return true;
+}
+
+// 从头回放当前片段直到结束，返回用时（毫秒），超过 limit 或不能开始时返回 ULONG_MAX
+static unsigned long playToEnd(unsigned long limit) {
+  const unsigned long start = clockMs;
+  if (!beginClipPlayback()) {
+    return ULONG_MAX;
+  }
+  while (updateClipPlayback()) {
+    advance(1);
+    if (clockMs - start > limit) {
+      return ULONG_MAX;
+    }
+  }
+  return clockMs - start;
+}
+
+// 录制 0 时刻和 gap 毫秒后的两个目标，检查往返结果
+static bool roundTrip(unsigned long gap, uint8_t id, int first, int second) {
+  char name[48];
+  snprintf(name, sizeof(name), "gap %lu ms, servo %u", gap, id);
+
+  startClipRecording();
+  clipRecordServo(id, first);
+  advance(gap);
+  clipRecordServo(id, second);
+  advance(HOLD_MS);
+  stopClipRecording();
+  if (!saveClip()) {
+    printf("FAIL %s: clip not saved\n", name);
+    return false;
+  }
+
+  uint8_t clip[CLIP_BUFFER_SIZE];
+  uint16_t length = IRobot::ClipStore().load(clip, sizeof(clip));
+  std::vector<Target> targets;
+  unsigned long duration = 0;
+  if (!decode(clip, length, targets, duration)) {
+    printf("FAIL %s: clip does not decode\n", name);
+    return false;
+  }
+  // 不足一个时间单位的部分留到下一个等待，因此第二个目标最多提前 CLIP_TIME_UNIT_MS - 1 毫秒
+  if (targets.size() != 2 || targets[0].time != 0 || targets[0].angle != first ||
+      targets[1].id != id || targets[1].angle != second || targets[1].time > gap ||
+      targets[1].time + CLIP_TIME_UNIT_MS <= gap) {
+    printf("FAIL %s: decoded targets do not match\n", name);
+    return false;
+  }
+  if (duration > gap + HOLD_MS || duration + CLIP_TIME_UNIT_MS <= gap + HOLD_MS) {
+    printf("FAIL %s: decoded duration %lu ms\n", name, duration);
+    return false;
+  }
+
+  // 固件回放：按原速播放，直到片段结束
+  if (!loadClip()) {
+    printf("FAIL %s: clip not loaded\n", name);
+    return false;
+  }
+  setClipSpeed(100);
+  unsigned long played = playToEnd(2 * (gap + HOLD_MS) + 1000);
+  if (played != duration) {
+    printf("FAIL %s: playback took %lu ms, clip is %lu ms\n", name, played, duration);
+    return false;
+  }
+  return true;
+}
+
+// 与固件相同的 CRC-8（多项式 0x07），依次计算序号和数据
+static uint8_t chunkCrc(uint8_t seq, const uint8_t *data, uint8_t length) {
+  uint8_t crc = 0;
+  for (int i = -1; i < length; i++) {
+    crc ^= i < 0 ? seq : data[i];
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+// 分块上传 copies 遍 clip，缓冲区满时推进回放腾出空间，全部写入时返回 true
+static bool upload(const uint8_t *clip, uint8_t length, uint8_t copies) {
+  beginClipUpload();
+  uint8_t seq = 0;
+  for (uint8_t copy = 0; copy < copies; copy++) {
+    for (uint8_t pos = 0; pos < length; pos += CLIP_CHUNK_MAX) {
+      uint8_t size = length - pos < CLIP_CHUNK_MAX ? length - pos : CLIP_CHUNK_MAX;
+      ClipChunkResult result;
+      while ((result = writeClipChunk(seq, clip + pos, size, chunkCrc(seq, clip + pos, size))) ==
+             ClipChunkResult::Full) {
+        // 缓冲区满时先回放一段，腾出空间
+        if (!updateClipPlayback()) {
+          return false;
+        }
+        advance(1);
+      }
+      if (result != ClipChunkResult::Ok) {
+        return false;
+      }
+      seq++;
+    }
+  }
+  finishClipUpload();
+  return true;
+}
+
+static bool uploadChecks() {
+  // 一个短片段：0 时刻和 300 毫秒后的两个目标，再保持 HOLD_MS
+  startClipRecording();
+  clipRecordServo(2, 90);
+  advance(300);
+  clipRecordServo(2, 120);
+  advance(HOLD_MS);
+  stopClipRecording();
+  saveClip();
+  uint8_t clip[CLIP_BUFFER_SIZE];
+  uint8_t length = IRobot::ClipStore().load(clip, sizeof(clip));
+  const unsigned long duration = 300 + HOLD_MS;
+  bool ok = true;
+
+  // 第一块之前不存在“上一块”，序号 255 不能被当作重发而确认
+  beginClipUpload();
+  if (writeClipChunk(255, clip, 1, chunkCrc(255, clip, 1)) != ClipChunkResult::OutOfOrder ||
+      clipExpectedSeq() != 0) {
+    printf("FAIL upload: chunk 255 accepted before the first chunk\n");
+    ok = false;
+  }
+
+  // 上传的短片段回放两遍，第二遍也要从头开始
+  setClipSpeed(100);
+  if (!upload(clip, length, 1) || playToEnd(2 * duration) != duration ||
+      playToEnd(2 * duration) != duration) {
+    printf("FAIL upload: uploaded clip does not replay from the start\n");
+    ok = false;
+  }
+
+  // 超过缓冲区的片段边上传边回放，之后不能再从头回放
+  const uint8_t copies = CLIP_BUFFER_SIZE / length + 2;
+  if (!beginClipPlayback() || !upload(clip, length, copies)) {
+    printf("FAIL upload: long clip upload failed\n");
+    ok = false;
+  } else if (beginClipPlayback()) {
+    printf("FAIL upload: long clip restarted after its start was overwritten\n");
+    ok = false;
+  }
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "-v") {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: cliptest [-v]\n");
+      return 2;
+    }
+  }
+  memset(EEPROM.data, 0xFF, sizeof(EEPROM.data));
+  freeRunning = false;
+  advance(1000);
+
+  // 短等待最多 63 个单位，64 个单位起使用长等待
+  const unsigned long unit = CLIP_TIME_UNIT_MS;
+  const unsigned long gaps[] = {unit, 2 * unit - 1, 62 * unit, 63 * unit, 63 * unit + 1,
+                                64 * unit, 64 * unit + unit - 1, 65 * unit, 1000, 0xFFFF,
+                                0xFFFF + 64 * unit};
+  int passed = 0, failed = 0;
+  for (unsigned long gap : gaps) {
+    // 变化小的目标编码为增量，变化大的编码为绝对角度
+    for (int second : {93, 150}) {
+      if (roundTrip(gap, 1, 90, second)) {
+        passed++;
+      } else {
+        failed++;
+      }
+    }
+  }
+  if (uploadChecks()) {
+    passed++;
+  } else {
+    failed++;
+  }
+  printf("cliptest: %d passed, %d failed\n", passed, failed);
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#!/bin/sh
+# 在 Linux 上编译固件并运行动作片段的往返测试
+#
+# 用法：tools/cliptest/cliptest.sh [-v]
+# 依赖 g++。
+
+set -e
+
+TOOL_DIR=$(cd "$(dirname "$0")" && pwd)
+SKETCH_DIR=$(cd "$TOOL_DIR/../.." && pwd)
+HOST_DIR="$SKETCH_DIR/tools/replay/host"
+BUILD_DIR=${BUILD_DIR:-"$SKETCH_DIR/build/cliptest"}
+CXX=${CXX:-g++}
+
+mkdir -p "$BUILD_DIR"
+"$CXX" -std=gnu++11 -O2 -g -Wall -Wextra -Wno-unused \
+  -I"$HOST_DIR" -I"$SKETCH_DIR" \
+  -x c++ "$SKETCH_DIR/robot-simple.ino" \
+  -x none "$SKETCH_DIR"/*.cpp "$HOST_DIR/Host.cpp" "$TOOL_DIR/cliptest.cpp" \
+  -o "$BUILD_DIR/cliptest"
+
+exec "$BUILD_DIR/cliptest" "$@"
@@ -0,0 +1,39 @@
+#!/bin/sh
+# 编译固件并按模块输出 flash / SRAM 占用
+#
+# 用法：tools/memreport.sh [构建目录]
+# 依赖 arduino-cli 以及 avr-size（随 Arduino AVR 工具链安装）。
+# flash = .text + .data，SRAM（静态部分）= .data + .bss
+
+set -e
+
+SKETCH_DIR=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_DIR=${1:-"$SKETCH_DIR/build"}
+FQBN=${FQBN:-arduino:avr:uno}
+AVR_SIZE=${AVR_SIZE:-avr-size}
+
+arduino-cli compile --fqbn "$FQBN" --build-path "$BUILD_DIR" "$SKETCH_DIR" >/dev/null
+
+printf '%-28s %8s %8s\n' "module" "flash" "sram"
+find "$BUILD_DIR/sketch" "$BUILD_DIR/libraries" "$BUILD_DIR/core" -name '*.o' 2>/dev/null |
+  sort |
+  xargs "$AVR_SIZE" -A |
+  awk '
+    /:$/ { name = $1; sub(/:$/, "", name); n = split(name, parts, "/"); name = parts[n]; sub(/\.o$/, "", name); next }
+    # 固件以 -ffunction-sections -fdata-sections 编译，按前缀归类
+    $1 ~ /^\.(text|progmem)/ { text[name] += $2 }
+    $1 ~ /^\.(data|rodata)/  { data[name] += $2 }
+    $1 ~ /^\.bss/            { bss[name] += $2 }
+    END {
+      for (m in bss) text[m] += 0
+      for (m in data) text[m] += 0
+      for (m in text) {
+        flash = text[m] + data[m]; sram = data[m] + bss[m]
+        if (flash || sram) printf "%-28s %8d %8d\n", m, flash, sram
+      }
+    }' |
+  sort -k3 -n -r
+
+ELF=$(find "$BUILD_DIR" -maxdepth 1 -name '*.elf' | head -n 1)
+echo
+"$AVR_SIZE" -C --mcu=atmega328p "$ELF"
@@ -0,0 +1,326 @@
+// 自动行走的导航模拟
+// 在 Linux 上运行固件，把机器人放在有随机柱子的房间里，按射线求出超声波读数，
+// 按动作状态推进机器人的位置，统计每分钟前进的距离、遇到障碍的次数、碰到障碍的阶段数，
+// 以及障碍实际进入避障距离到固件开始避障的反应延迟（平均 / 最大，毫秒），用于比较避障方式。
+//
+// 机器人位置按行为级模型推进：自动行走每个阶段前进固定距离，并按当前周期的转向量转动，
+// 转向每个阶段转过固定角度，扫描时身体朝向随扫描方向改变。模型只用于在相同条件下比较固件的决策，不代表实际速度。
+//
+// 用法：navsim [-m 避障方式] [-n 场景数] [-p 柱子数] [-t 秒] [-v]
+//   -m  0 轮流左右转，1 扫描后选择方向，2 边走边转；缺省时各种方式都运行并比较
+//   -n  随机场景数量（缺省 20），每种方式使用相同的场景
+//   -p  房间中的柱子数量（缺省 20），越多越拥挤
+//   -t  每个场景的模拟时长（缺省 300 秒）
+//   -v  输出固件的串口内容
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "Host.h"
+
+#include "RobotMotion.h"
+#include "RobotScan.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+//-=================== 模拟参数 ========================
+
+static const double ROOM_MM = 3000;         // 正方形房间的边长
+static const double PILLAR_MIN_MM = 80;     // 柱子半径范围
+static const double PILLAR_MAX_MM = 250;
+static const double BODY_RADIUS_MM = BODY_WIDTH_MM / 2.0; // 机器人碰撞半径
+static const double SENSOR_RANGE_MM = 6890; // 超声波量程，对应 40ms 超时（40000us / 58us 每厘米）
+static const double BEAM_HALF_DEG = 15;     // 超声波波束半角，取波束内五条射线的最近值
+static const double STEP_MM = 40.0 / 8;     // 自动行走每个阶段前进的距离（每周期 40mm）
+static const double TURN_DEG = 18.0 / 6;    // 转向每个阶段转过的角度（每周期 18 度），与缺省的转向标定一致
+static const double TURN_AMPLITUDE = 20;    // TURN_DEG 对应的髋关节幅度，转过的角度与幅度成正比
+static const double STEER_DEG = 35.0 / 8;   // 转向量 100% 时行走每个阶段转过的角度
+
+static const double PI = 3.14159265358979;
+
+struct Pillar {
+  double x, y, r;
+};
+
+struct World {
+  std::vector<Pillar> pillars;
+  double x, y, heading; // 机器人位置（毫米）和朝向（度，逆时针为正）
+};
+
+struct Result {
+  double distance = 0;        // 前进的距离（毫米）
+  unsigned long bumps = 0;    // 碰到障碍（被挡住或擦着滑过）的阶段数
+  unsigned long obstacles = 0; // 遇到障碍的次数
+  unsigned long reactions = 0;    // 障碍进入避障距离后固件做出反应的次数
+  unsigned long reactionSum = 0;  // 反应延迟之和（毫秒）
+  unsigned long reactionMax = 0;
+};
+
+//-=================== 场景 ========================
+
+static int pillarCount = 20; // 柱子数量
+
+static World makeWorld(unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> pos(0, ROOM_MM);
+  std::uniform_real_distribution<double> radius(PILLAR_MIN_MM, PILLAR_MAX_MM);
+  World world;
+  world.x = ROOM_MM / 2;
+  world.y = ROOM_MM / 2;
+  world.heading = std::uniform_real_distribution<double>(0, 360)(rng);
+  while (static_cast<int>(world.pillars.size()) < pillarCount) {
+    Pillar p = {pos(rng), pos(rng), radius(rng)};
+    // 出发点附近留出空间
+    if (std::hypot(p.x - world.x, p.y - world.y) > p.r + 300) {
+      world.pillars.push_back(p);
+    }
+  }
+  return world;
+}
+
+// 从 (x, y) 沿 angle 方向到最近障碍的距离
+static double castRay(const World &world, double x, double y, double angle) {
+  double dx = std::cos(angle * PI / 180), dy = std::sin(angle * PI / 180);
+  double best = 1e9;
+  // 墙
+  if (dx > 0) best = std::min(best, (ROOM_MM - x) / dx);
+  if (dx < 0) best = std::min(best, -x / dx);
+  if (dy > 0) best = std::min(best, (ROOM_MM - y) / dy);
+  if (dy < 0) best = std::min(best, -y / dy);
+  // 柱子
+  for (const Pillar &p : world.pillars) {
+    double fx = x - p.x, fy = y - p.y;
+    double b = fx * dx + fy * dy;
+    double c = fx * fx + fy * fy - p.r * p.r;
+    double disc = b * b - c;
+    if (disc >= 0) {
+      double t = -b - std::sqrt(disc);
+      if (t >= 0) best = std::min(best, t);
+    }
+  }
+  return best;
+}
+
+// (x, y) 处是否与障碍重叠，重叠时给出接触面的法线（指向机器人）
+static bool collides(const World &world, double x, double y, double *normalX = nullptr,
+                     double *normalY = nullptr) {
+  double nx = 0, ny = 0;
+  if (x < BODY_RADIUS_MM) nx = 1;
+  else if (x > ROOM_MM - BODY_RADIUS_MM) nx = -1;
+  else if (y < BODY_RADIUS_MM) ny = 1;
+  else if (y > ROOM_MM - BODY_RADIUS_MM) ny = -1;
+  for (const Pillar &p : world.pillars) {
+    double d = std::hypot(x - p.x, y - p.y);
+    if (nx == 0 && ny == 0 && d < p.r + BODY_RADIUS_MM) {
+      nx = (x - p.x) / d;
+      ny = (y - p.y) / d;
+    }
+  }
+  if (nx == 0 && ny == 0) return false;
+  if (normalX) *normalX = nx;
+  if (normalY) *normalY = ny;
+  return true;
+}
+
+// 扫描时身体相对行走方向的偏转：第 n 个阶段（sharedCounter 为 n + 1）髋关节已转到第 n 次的方向
+static double bodyYaw() {
+  if (currentMotionId == RobotMotionId::Scanning &&
+      currentMotionState == RobotMotionState::InProgress && sharedCounter > 0) {
+    uint8_t bin = scanBinAt(sharedCounter - 1);
+    return bin < SCAN_BINS ? scanBinAngle(bin) : 0;
+  }
+  return 0;
+}
+
+//-=================== 运行 ========================
+
+static void sendCommand(const char *command) {
+  while (*command) serialInput.push_back(*command++);
+  serialInput.push_back('\r');
+}
+
+static Result run(unsigned seed, int mode, unsigned long seconds) {
+  World world = makeWorld(seed);
+  std::mt19937 rng(seed);
+  Result result;
+
+  memset(EEPROM.data, 0xFF, sizeof(EEPROM.data));
+  trimLoader.load();
+  reverseLoader.load();
+  poseLoader.load();
+  resetLog.load();
+
+  // 固件的状态是全局的，每个场景从上一个场景结束时的时间继续
+  serialInput.clear();
+  freeRunning = true;
+  static bool started = false;
+  if (!started) {
+    setup();
+    started = true;
+  }
+  freeRunning = false;
+
+  char command[16];
+  snprintf(command, sizeof(command), "P O %d", mode);
+  sendCommand(command);
+  sendCommand("A");
+
+  const unsigned long end = clockMs + seconds * 1000;
+  RobotMotionId lastMotion = currentMotionId;
+  RobotMotionState lastState = currentMotionState;
+  uint16_t lastCounter = sharedCounter;
+  unsigned long dangerSince = 0; // 障碍实际进入避障距离的时间，0 表示没有
+
+  while (clockMs < end) {
+    clockMs += 1 + rng() % 3;
+
+    // 本次循环的超声波读数
+    double heading = world.heading + bodyYaw();
+    double range = SENSOR_RANGE_MM + 1;
+    for (int i = -2; i <= 2; i++) {
+      range = std::min(range, castRay(world, world.x, world.y, heading + i * BEAM_HALF_DEG / 2));
+    }
+    distanceInput.clear();
+    for (int i = 0; i < 8; i++) {
+      // 超出量程时 pulseIn 超时返回 0
+      distanceInput.push_back(range > SENSOR_RANGE_MM ? 0 : static_cast<int>(range));
+    }
+
+    // 反应延迟：从障碍实际进入避障距离，到固件离开自动行走开始避障
+    bool walking = currentMotionId == RobotMotionId::AutoWalking &&
+                   currentMotionState == RobotMotionState::InProgress;
+    if (walking && range < AVOID_DISTANCE_MM) {
+      if (dangerSince == 0) {
+        dangerSince = clockMs;
+      }
+    } else {
+      dangerSince = 0;
+    }
+
+    loop();
+
+    if (dangerSince != 0 && currentMotionId != RobotMotionId::AutoWalking) {
+      unsigned long latency = clockMs - dangerSince;
+      result.reactions++;
+      result.reactionSum += latency;
+      result.reactionMax = std::max(result.reactionMax, latency);
+      dangerSince = 0;
+    }
+
+    // 按阶段推进位置。动作切换后要到下一次循环开始时才重置（或恢复）计数器，这时只重新记录计数器。
+    // 避障请求随测距事件在同一次循环内生效，自动行走可能在一次循环内恢复后又被打断，
+    // 这时动作ID不变，但动作已经重新切换，尚未开始
+    bool started = lastState == RobotMotionState::NotStarted;
+    bool switched = currentMotionId != lastMotion ||
+                    (currentMotionState == RobotMotionState::NotStarted && !started);
+    lastState = currentMotionState;
+    if (switched || started) {
+      if (switched &&
+          (currentMotionId == RobotMotionId::Scanning ||
+           ((lastMotion == RobotMotionId::AutoWalking || currentMotionId == lastMotion) &&
+            (currentMotionId == RobotMotionId::TurningLeft ||
+             currentMotionId == RobotMotionId::TurningRight)))) {
+        result.obstacles++;
+      }
+      lastMotion = currentMotionId;
+      lastCounter = sharedCounter;
+      continue;
+    }
+    if (sharedCounter == lastCounter) {
+      continue;
+    }
+    uint16_t steps = static_cast<uint16_t>(sharedCounter - lastCounter);
+    lastCounter = sharedCounter;
+    switch (currentMotionId) {
+    case RobotMotionId::AutoWalking:
+      for (uint16_t i = 0; i < steps; i++) {
+        world.heading += currentWalkSteer() * STEER_DEG / MOTION_STEER_MAX;
+        double dx = STEP_MM * std::cos(world.heading * PI / 180);
+        double dy = STEP_MM * std::sin(world.heading * PI / 180);
+        double normalX, normalY;
+        if (collides(world, world.x + dx, world.y + dy, &normalX, &normalY)) {
+          // 擦到障碍时沿接触面滑过，只有正对障碍时才完全被挡住
+          result.bumps++;
+          double into = dx * normalX + dy * normalY;
+          dx -= into * normalX;
+          dy -= into * normalY;
+          if (collides(world, world.x + dx, world.y + dy)) {
+            continue;
+          }
+        }
+        world.x += dx;
+        world.y += dy;
+        result.distance += std::hypot(dx, dy);
+      }
+      break;
+    case RobotMotionId::TurningLeft:
+      world.heading += steps * TURN_DEG * currentTurnAmplitude() / TURN_AMPLITUDE;
+      break;
+    case RobotMotionId::TurningRight:
+      world.heading -= steps * TURN_DEG * currentTurnAmplitude() / TURN_AMPLITUDE;
+      break;
+    default:
+      break;
+    }
+  }
+
+  // 停下，为下一个场景做准备
+  setMovingState(RobotMotionId::Idle);
+  for (int i = 0; i < 2000; i++) {
+    clockMs += 2;
+    loop();
+  }
+  return result;
+}
+
+int main(int argc, char **argv) {
+  int mode = -1;
+  int scenes = 20;
+  unsigned long seconds = 300;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-m" && i + 1 < argc) {
+      mode = atoi(argv[++i]);
+    } else if (arg == "-n" && i + 1 < argc) {
+      scenes = atoi(argv[++i]);
+    } else if (arg == "-p" && i + 1 < argc) {
+      pillarCount = atoi(argv[++i]);
+    } else if (arg == "-t" && i + 1 < argc) {
+      seconds = strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "-v") {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: navsim [-m mode] [-n scenes] [-p pillars] [-t seconds] [-v]\n");
+      return 2;
+    }
+  }
+
+  const char *names[] = {"alternate", "scan", "steer"};
+  printf("%-10s %12s %10s %8s %14s\n", "mode", "mm/min", "obstacles", "bumps", "reaction ms");
+  for (int m = 0; m <= 2; m++) {
+    if (mode >= 0 && m != mode) {
+      continue;
+    }
+    Result total;
+    for (int s = 0; s < scenes; s++) {
+      Result r = run(s + 1, m, seconds);
+      total.distance += r.distance;
+      total.obstacles += r.obstacles;
+      total.bumps += r.bumps;
+      total.reactions += r.reactions;
+      total.reactionSum += r.reactionSum;
+      total.reactionMax = std::max(total.reactionMax, r.reactionMax);
+    }
+    double minutes = scenes * seconds / 60.0;
+    printf("%-10s %12.0f %10.1f %8.1f %6.0f / %5lu\n", names[m], total.distance / minutes,
+           total.obstacles / minutes, total.bumps / minutes,
+           total.reactions ? static_cast<double>(total.reactionSum) / total.reactions : 0.0,
+           total.reactionMax);
+  }
+  return 0;
+}
@@ -0,0 +1,22 @@
+#!/bin/sh
+# 在 Linux 上编译固件并运行自动行走的导航模拟
+#
+# 用法：tools/navsim/navsim.sh [-m 避障方式] [-n 场景数] [-p 柱子数] [-t 秒] [-v]
+# 依赖 g++。
+
+set -e
+
+TOOL_DIR=$(cd "$(dirname "$0")" && pwd)
+SKETCH_DIR=$(cd "$TOOL_DIR/../.." && pwd)
+HOST_DIR="$SKETCH_DIR/tools/replay/host"
+BUILD_DIR=${BUILD_DIR:-"$SKETCH_DIR/build/navsim"}
+CXX=${CXX:-g++}
+
+mkdir -p "$BUILD_DIR"
+"$CXX" -std=gnu++11 -O2 -g -Wall -Wno-unused \
+  -I"$HOST_DIR" -I"$SKETCH_DIR" \
+  -x c++ "$SKETCH_DIR/robot-simple.ino" \
+  -x none "$SKETCH_DIR"/*.cpp "$HOST_DIR/Host.cpp" "$TOOL_DIR/navsim.cpp" \
+  -o "$BUILD_DIR/navsim"
+
+exec "$BUILD_DIR/navsim" "$@"
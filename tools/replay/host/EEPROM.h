@@ -0,0 +1,18 @@
+#pragma once
+// 回放用的 EEPROM，内容来自记录头
+
+#include <Arduino.h>
+
+#define EEPROM_HOST_SIZE 1024
+
+class EEPROMClass {
+public:
+  uint8_t read(int addr) { return data[addr]; }
+  void write(int addr, uint8_t value) { data[addr] = value; }
+  void update(int addr, uint8_t value) { data[addr] = value; }
+  uint16_t length() { return EEPROM_HOST_SIZE; }
+
+  uint8_t data[EEPROM_HOST_SIZE];
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,107 @@
+// 主机上的 Arduino 环境实现，供回放工具和导航模拟共用
+// 时间、串口输入和超声波读数由调用方在每次循环前设置。
+
+#include "Host.h"
+
+#include <EEPROM.h>
+
+#include <cstdio>
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+
+unsigned long clockMs = 0;
+bool freeRunning = true; // setup() 期间每次读取时间前进 1 毫秒，保证等待循环能结束
+bool verbose = false;
+std::deque<uint8_t> serialInput; // 本次循环读取的串口字节
+std::deque<int> distanceInput;   // 本次循环的超声波读数
+unsigned long unexpectedReads = 0;
+
+unsigned long millis() { return freeRunning ? clockMs++ : clockMs; }
+unsigned long micros() { return clockMs * 1000; }
+void delay(unsigned long ms) { clockMs += ms; }
+void delayMicroseconds(unsigned int) {}
+
+void pinMode(uint8_t, uint8_t) {}
+void digitalWrite(uint8_t, uint8_t) {}
+int digitalRead(uint8_t) { return LOW; }
+
+unsigned long pulseIn(uint8_t, uint8_t, unsigned long) {
+  if (distanceInput.empty()) {
+    unexpectedReads++;
+    return 0;
+  }
+  int distance = distanceInput.front();
+  distanceInput.pop_front();
+  // US::read() 的逆运算：读数以毫米记录，US::read() 返回厘米，getUSDistance() 再乘 10
+  return static_cast<unsigned long>(distance) * 29 * 2 / 10;
+}
+
+volatile uint8_t *portOutputRegister(uint8_t) {
+  static volatile uint8_t port;
+  return &port;
+}
+
+void noInterrupts() {}
+void interrupts() {}
+
+char *dtostrf(double value, signed char width, unsigned char precision, char *buffer) {
+  sprintf(buffer, "%*.*f", width, precision, value);
+  return buffer;
+}
+
+size_t Print::write(const char *text) {
+  size_t n = 0;
+  while (*text) {
+    n += write(static_cast<uint8_t>(*text++));
+  }
+  return n;
+}
+
+size_t Print::print(const __FlashStringHelper *text) {
+  return write(reinterpret_cast<const char *>(text));
+}
+size_t Print::print(const char *text) { return write(text); }
+size_t Print::print(char value) { return write(static_cast<uint8_t>(value)); }
+size_t Print::print(unsigned char value, int base) {
+  return print(static_cast<unsigned long>(value), base);
+}
+size_t Print::print(int value, int base) { return print(static_cast<long>(value), base); }
+size_t Print::print(unsigned int value, int base) {
+  return print(static_cast<unsigned long>(value), base);
+}
+size_t Print::print(long value, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%ld", value);
+  return write(text);
+}
+size_t Print::print(unsigned long value, int base) {
+  char text[24];
+  snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+  return write(text);
+}
+size_t Print::print(double value, int digits) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return write(text);
+}
+size_t Print::println() { return write("\r\n"); }
+
+void HardwareSerial::begin(unsigned long) {}
+int HardwareSerial::available() { return static_cast<int>(serialInput.size()); }
+int HardwareSerial::read() {
+  if (serialInput.empty()) {
+    return -1;
+  }
+  uint8_t value = serialInput.front();
+  serialInput.pop_front();
+  return value;
+}
+int HardwareSerial::peek() { return serialInput.empty() ? -1 : serialInput.front(); }
+int HardwareSerial::availableForWrite() { return 63; }
+size_t HardwareSerial::write(uint8_t value) {
+  if (verbose) {
+    putchar(value);
+  }
+  return 1;
+}
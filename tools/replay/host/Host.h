@@ -0,0 +1,27 @@
+#pragma once
+// 主机上运行固件时由工具控制的输入，以及工具需要直接访问的固件对象
+
+#include <Arduino.h>
+
+#include <deque>
+
+#include "loadPose.h"
+#include "loadResetLog.h"
+#include "loadReverse.h"
+#include "loadTrim.h"
+
+extern unsigned long clockMs;            // 当前时间（毫秒）
+extern bool freeRunning;                 // 为 true 时每次读取时间前进 1 毫秒，供 setup() 使用
+extern bool verbose;                     // 是否输出固件的串口内容
+extern std::deque<uint8_t> serialInput;  // 本次循环读取的串口字节
+extern std::deque<int> distanceInput;    // 本次循环的超声波读数（毫米）
+extern unsigned long unexpectedReads;    // 超声波读数用完后仍然测距的次数
+
+// 固件入口
+void setup();
+void loop();
+
+extern IRobot::ServoTrim trimLoader;
+extern IRobot::ServoReverse reverseLoader;
+extern IRobot::ServoPose poseLoader;
+extern IRobot::ResetLog resetLog;
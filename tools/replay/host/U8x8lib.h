@@ -0,0 +1,17 @@
+#pragma once
+// 回放时不驱动屏幕，显示内容直接丢弃
+
+#include <Arduino.h>
+
+static const uint8_t u8x8_font_5x7_f[] = {0};
+
+class U8X8_SH1106_128X32_VISIONOX_HW_I2C : public Print {
+public:
+  void begin() {}
+  void setFont(const uint8_t *) {}
+  void clear() {}
+  void clearLine(uint8_t) {}
+  void setCursor(uint8_t, uint8_t) {}
+  void drawString(uint8_t, uint8_t, const char *) {}
+  size_t write(uint8_t) override { return 1; }
+};
@@ -0,0 +1,325 @@
+// 输入记录回放工具
+// 从串口日志中提取 "~" 开头的记录行，用记录的时间、串口字节和超声波读数
+// 驱动 Linux 版固件，检查动作状态的变化与现场一致，并统计每次循环的耗时。
+//
+// 用法：replay [-v] [-s 倍速] <串口日志>
+//   -v  输出固件的串口内容
+//   -s  按指定倍速回放（缺省为尽可能快）
+// 返回值：0 一致，1 状态不一致，2 记录无法回放
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "Host.h"
+
+#include "RobotMotion.h"
+#include "RobotTrace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//-=================== 记录解析 ========================
+
+struct Checkpoint {
+  uint8_t motionId;
+  uint8_t state;
+  uint8_t counter;
+};
+
+struct Tick {
+  unsigned long time;
+  std::vector<uint8_t> serial;
+  std::vector<int> distances;
+  std::vector<Checkpoint> checkpoints;
+};
+
+class TraceReader {
+public:
+  explicit TraceReader(const std::vector<uint8_t> &data) : data(data) {}
+
+  bool readHeader(unsigned long &start) {
+    if (remaining() < 5 + TRACE_EEPROM_BYTES || data[pos] != TRACE_HEADER) {
+      return false;
+    }
+    pos++;
+    start = 0;
+    for (int i = 0; i < 4; i++) {
+      start |= static_cast<unsigned long>(data[pos++]) << (8 * i);
+    }
+    for (int addr = 0; addr < TRACE_EEPROM_BYTES; addr++) {
+      EEPROM.write(addr, data[pos++]);
+    }
+    time = start;
+    return true;
+  }
+
+  // 读取下一次循环及其输入，记录结束或数据丢失时返回 false
+  bool next(Tick &tick) {
+    tick.serial.clear();
+    tick.distances.clear();
+    tick.checkpoints.clear();
+    if (repeats == 0) {
+      if (remaining() == 0) {
+        return false;
+      }
+      uint8_t code = data[pos];
+      if (code <= TRACE_TICK_MAX) {
+        pos++;
+        delta = code;
+        repeats = 1;
+      } else if (code < TRACE_TICK_LONG) {
+        pos++;
+        repeats = (code & TRACE_TICK_MAX) + 1;
+      } else if (code == TRACE_TICK_LONG && remaining() >= 3) {
+        delta = data[pos + 1] | (data[pos + 2] << 8);
+        pos += 3;
+        repeats = 1;
+      } else {
+        return fail(code);
+      }
+    }
+    time += delta;
+    tick.time = time;
+    // 重复记录中只有最后一次循环可能带有输入
+    if (--repeats == 0) {
+      return readInputs(tick);
+    }
+    return true;
+  }
+
+  bool lost() const { return lostBytes != 0; }
+  bool malformed() const { return bad; }
+
+private:
+  size_t remaining() const { return data.size() - pos; }
+
+  bool fail(uint8_t code) {
+    if (code == TRACE_LOST && remaining() >= 3) {
+      lostBytes = data[pos + 1] | (data[pos + 2] << 8);
+    } else {
+      bad = true;
+    }
+    return false;
+  }
+
+  bool readInputs(Tick &tick) {
+    while (remaining() != 0) {
+      uint8_t code = data[pos];
+      if (code == TRACE_SERIAL && remaining() >= 2) {
+        tick.serial.push_back(data[pos + 1]);
+        pos += 2;
+      } else if (code == TRACE_DISTANCE && remaining() >= 3) {
+        tick.distances.push_back(static_cast<int16_t>(data[pos + 1] | (data[pos + 2] << 8)));
+        pos += 3;
+      } else if (code == TRACE_CHECKPOINT && remaining() >= 4) {
+        tick.checkpoints.push_back({data[pos + 1], data[pos + 2], data[pos + 3]});
+        pos += 4;
+      } else if (code == TRACE_LOST) {
+        // 本次循环的输入不完整，不再回放
+        return fail(code);
+      } else {
+        break;
+      }
+    }
+    return true;
+  }
+
+  const std::vector<uint8_t> &data;
+  size_t pos = 0;
+  unsigned long time = 0;
+  uint16_t delta = 0;
+  uint8_t repeats = 0;
+  uint16_t lostBytes = 0;
+  bool bad = false;
+};
+
+static int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  return -1;
+}
+
+// 从日志中提取记录行，忽略调试输出
+static bool loadTrace(const char *path, std::vector<uint8_t> &data) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] != '~') {
+      continue;
+    }
+    for (size_t i = 1; i + 1 < line.size(); i += 2) {
+      int high = hexValue(line[i]);
+      int low = hexValue(line[i + 1]);
+      if (high < 0 || low < 0) {
+        break; // 行尾的 \r
+      }
+      data.push_back(static_cast<uint8_t>(high << 4 | low));
+    }
+  }
+  return true;
+}
+
+//-=================== 回放 ========================
+
+static void printCheckpoint(const char *label, const Checkpoint &c) {
+  printf("  %s: motion %u state %u counter %u\n", label, c.motionId, c.state, c.counter);
+}
+
+int main(int argc, char **argv) {
+  double speed = 0; // 0 表示不限速
+  const char *path = nullptr;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "-v") {
+      verbose = true;
+    } else if (arg == "-s" && i + 1 < argc) {
+      speed = atof(argv[++i]);
+    } else {
+      path = argv[i];
+    }
+  }
+  if (path == nullptr) {
+    fprintf(stderr, "usage: %s [-v] [-s speed] <serial log>\n", argv[0]);
+    return 2;
+  }
+
+  std::vector<uint8_t> data;
+  if (!loadTrace(path, data)) {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 2;
+  }
+  TraceReader reader(data);
+  unsigned long start = 0;
+  if (!reader.readHeader(start)) {
+    fprintf(stderr, "no trace header in %s\n", path);
+    return 2;
+  }
+
+  // 用记录时的 EEPROM 内容重新加载修剪值、反转和姿态
+  trimLoader.load();
+  reverseLoader.load();
+  poseLoader.load();
+  resetLog.load();
+  setup();
+  freeRunning = false;
+  clockMs = start;
+
+  typedef std::chrono::steady_clock Clock;
+  const Clock::time_point wallStart = Clock::now();
+  Checkpoint last = {0xFF, 0xFF, 0};
+  unsigned long ticks = 0;
+  unsigned long transitions = 0;
+  double totalUs = 0;
+  double maxUs = 0;
+  unsigned long slowestTime = 0;
+  unsigned long histogram[16] = {}; // 每次循环耗时，按 2 的幂分桶（微秒）
+  int result = 0;
+
+  Tick tick;
+  while (reader.next(tick)) {
+    clockMs = tick.time;
+    serialInput.assign(tick.serial.begin(), tick.serial.end());
+    distanceInput.assign(tick.distances.begin(), tick.distances.end());
+    unexpectedReads = 0;
+
+    if (speed > 0) {
+      // 按倍速等待到本次循环的时间
+      std::this_thread::sleep_until(
+          wallStart + std::chrono::microseconds(static_cast<long long>(
+                          (tick.time - start) * 1000.0 / speed)));
+    }
+    const Clock::time_point before = Clock::now();
+    loop();
+    const double us =
+        std::chrono::duration<double, std::micro>(Clock::now() - before).count();
+
+    ticks++;
+    totalUs += us;
+    if (us > maxUs) {
+      maxUs = us;
+      slowestTime = tick.time;
+    }
+    int bucket = 0;
+    while (bucket < 15 && (1u << bucket) <= us) {
+      bucket++;
+    }
+    histogram[bucket]++;
+
+    // 检查输入是否被同样地消耗
+    if (!serialInput.empty() || !distanceInput.empty() || unexpectedReads != 0) {
+      printf("input mismatch at %lu ms: %zu serial bytes and %zu readings left, "
+             "%lu unexpected readings\n",
+             tick.time, serialInput.size(), distanceInput.size(), unexpectedReads);
+      result = 1;
+      break;
+    }
+
+    // 检查动作状态的变化
+    // 与 endTick() 相同，计数器只在进行中状态比较
+    Checkpoint now = {static_cast<uint8_t>(currentMotionId),
+                      static_cast<uint8_t>(currentMotionState),
+                      currentMotionState == RobotMotionState::InProgress
+                          ? static_cast<uint8_t>(sharedCounter)
+                          : static_cast<uint8_t>(0)};
+    bool changed = now.motionId != last.motionId || now.state != last.state ||
+                   now.counter != last.counter;
+    size_t expected = tick.checkpoints.size();
+    if (changed != (expected != 0) ||
+        (changed && (now.motionId != tick.checkpoints[0].motionId ||
+                     now.state != tick.checkpoints[0].state ||
+                     now.counter != tick.checkpoints[0].counter))) {
+      printf("state mismatch at %lu ms (tick %lu)\n", tick.time, ticks);
+      if (expected != 0) {
+        printCheckpoint("recorded", tick.checkpoints[0]);
+      }
+      printCheckpoint("replayed", now);
+      result = 1;
+      break;
+    }
+    if (changed) {
+      transitions++;
+      last = now;
+    }
+  }
+
+  if (result == 0 && reader.lost()) {
+    printf("trace incomplete: bytes were lost on the robot, stopped at %lu ms\n", clockMs);
+    result = 2;
+  } else if (result == 0 && reader.malformed()) {
+    printf("malformed trace, stopped at %lu ms\n", clockMs);
+    result = 2;
+  }
+
+  const double wallMs =
+      std::chrono::duration<double, std::milli>(Clock::now() - wallStart).count();
+  const double simMs = static_cast<double>(clockMs - start);
+  printf("Replay %s\n", result == 0 ? "matched" : "stopped");
+  printf("  ticks: %lu\n", ticks);
+  printf("  state transitions: %lu\n", transitions);
+  printf("  trace bytes: %zu (%.1f per second)\n", data.size(),
+         simMs > 0 ? data.size() * 1000.0 / simMs : 0.0);
+  printf("  simulated time (s): %.3f\n", simMs / 1000);
+  printf("  wall time (s): %.3f\n", wallMs / 1000);
+  printf("  speed-up: %.1fx\n", wallMs > 0 ? simMs / wallMs : 0.0);
+  printf("  tick cost (us): mean %.2f, max %.2f at %lu ms\n",
+         ticks ? totalUs / ticks : 0.0, maxUs, slowestTime);
+  printf("  tick cost histogram (us):\n");
+  for (int i = 0; i < 16; i++) {
+    if (histogram[i] != 0) {
+      printf("    < %5u: %lu\n", 1u << i, histogram[i]);
+    }
+  }
+  return result;
+}
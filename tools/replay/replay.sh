@@ -0,0 +1,22 @@
+#!/bin/sh
+# 在 Linux 上编译固件并回放机器人记录的输入
+#
+# 用法：tools/replay/replay.sh [-v] [-s 倍速] <串口日志>
+# 记录方法：复位机器人后在启动窗口内发送 X，保存串口输出到日志，结束时发送 X。
+# 依赖 g++。
+
+set -e
+
+TOOL_DIR=$(cd "$(dirname "$0")" && pwd)
+SKETCH_DIR=$(cd "$TOOL_DIR/../.." && pwd)
+BUILD_DIR=${BUILD_DIR:-"$SKETCH_DIR/build/replay"}
+CXX=${CXX:-g++}
+
+mkdir -p "$BUILD_DIR"
+"$CXX" -std=gnu++11 -O2 -g -Wall -Wno-unused \
+  -I"$TOOL_DIR/host" -I"$SKETCH_DIR" \
+  -x c++ "$SKETCH_DIR/robot-simple.ino" \
+  -x none "$SKETCH_DIR"/*.cpp "$TOOL_DIR/host/Host.cpp" "$TOOL_DIR/replay.cpp" \
+  -o "$BUILD_DIR/replay"
+
+exec "$BUILD_DIR/replay" "$@"
@@ -0,0 +1,240 @@
+// 动作脚本等待点的测试
+// 在 Linux 上运行固件，检查脚本的两种等待：
+// 唱歌按 MOTION_WAIT_MS 的节拍唱完每个音符，总时长等于音符数乘以音符时长；
+// 扫描在每个方向用 MOTION_WAIT_EVENT 等待舵机到位之后的一次新测距。
+// 超声波读数按髋关节的估计位置给出：到位时每个方向的距离各不相同，转动途中给出另一个距离，
+// 距离表中的每一项都必须是对应方向到位之后的读数。
+// 另外检查避障请求不经过会丢事件的缓冲区：缓冲区在障碍读数之后已满时，自动行走仍然转入避障并恢复，
+// 恢复后第一个步态周期里四个髋关节都要离开避障结束时的位置。
+//
+// 用法：scripttest [-v]
+//   -v  输出固件的串口内容
+// 全部通过时返回 0。
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include "Host.h"
+
+#include "RobotEvents.h"
+#include "RobotMotion.h"
+#include "RobotScan.h"
+#include "RobotServoControl.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static const int MOVING_MM = 999;      // 髋关节还在转动时的读数
+static const unsigned long LIMIT_MS = 10000; // 每项检查的时间上限
+static int fixedDistance = 0;                // 不为 0 时所有读数都是这个距离（毫米）
+
+// 到位时第 bin 个方向的读数，都小于 SCAN_CLEAR_MM，两侧都会测量
+static int binDistance(uint8_t bin) { return 200 + 10 * bin; }
+
+// 髋关节的估计位置正好是某个方向（中心位置 90 度减去该方向的偏移）时返回该方向，否则返回 SCAN_BINS
+static uint8_t hipBin() {
+  int16_t deci = servoEstimatedDeci(BodyLayout::servo(0, 0));
+  for (uint8_t bin = 0; bin < SCAN_BINS; bin++) {
+    if (deci == (90 - scanBinAngle(bin)) * 10) {
+      return bin;
+    }
+  }
+  return SCAN_BINS;
+}
+
+// 时间前进 1 毫秒并运行一次循环，读数按髋关节的位置给出
+static void step() {
+  clockMs += 1;
+  uint8_t bin = hipBin();
+  distanceInput.clear();
+  distanceInput.push_back(fixedDistance ? fixedDistance : bin < SCAN_BINS ? binDistance(bin)
+                                                                          : MOVING_MM);
+  loop();
+}
+
+// 切换到 motion 并运行到它开始，超时返回 false
+static bool start(RobotMotionId motion) {
+  setMovingState(motion);
+  const unsigned long begin = clockMs;
+  while (currentMotionId != motion || currentMotionState != RobotMotionState::InProgress) {
+    step();
+    if (clockMs - begin > LIMIT_MS) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 回到空闲并等舵机到位
+static void settle() {
+  setMovingState(RobotMotionId::Idle);
+  const unsigned long begin = clockMs;
+  while (clockMs - begin < 2000) {
+    step();
+  }
+}
+
+static bool singingCheck() {
+  settle();
+  if (!start(RobotMotionId::Singing)) {
+    printf("FAIL singing: did not start\n");
+    return false;
+  }
+  const unsigned long begin = clockMs;
+  uint16_t counter = sharedCounter;
+  unsigned long noteStart = begin;
+  bool ok = true;
+  while (currentMotionId == RobotMotionId::Singing &&
+         currentMotionState == RobotMotionState::InProgress) {
+    step();
+    if (sharedCounter != counter) {
+      // 每个音符至少持续 noteMs，最多多出一次循环
+      unsigned long note = clockMs - noteStart;
+      if (note < MOTION_SING_NOTE_MS || note > MOTION_SING_NOTE_MS + 1) {
+        printf("FAIL singing: note %u took %lu ms\n", counter, note);
+        ok = false;
+      }
+      counter = sharedCounter;
+      noteStart = clockMs;
+    }
+    if (clockMs - begin > LIMIT_MS) {
+      printf("FAIL singing: did not finish\n");
+      return false;
+    }
+  }
+  const unsigned long duration = clockMs - begin;
+  const unsigned long expected =
+      static_cast<unsigned long>(MOTION_SING_NOTES) * MOTION_SING_NOTE_MS;
+  if (counter != MOTION_SING_NOTES || duration < expected ||
+      duration > expected + MOTION_SING_NOTES) {
+    printf("FAIL singing: %u notes in %lu ms, expected %u in %lu ms\n", counter, duration,
+           MOTION_SING_NOTES, expected);
+    ok = false;
+  }
+  return ok;
+}
+
+static bool scanningCheck() {
+  settle();
+  if (!start(RobotMotionId::Scanning)) {
+    printf("FAIL scanning: did not start\n");
+    return false;
+  }
+  const unsigned long begin = clockMs;
+  while (currentMotionId == RobotMotionId::Scanning &&
+         currentMotionState == RobotMotionState::InProgress) {
+    step();
+    if (clockMs - begin > LIMIT_MS) {
+      printf("FAIL scanning: did not finish\n");
+      return false;
+    }
+  }
+  // 正前方沿用发现障碍时的读数，其余方向都要测量
+  bool ok = true;
+  for (uint8_t bin = 0; bin < SCAN_BINS; bin++) {
+    if (bin == SCAN_BINS / 2) {
+      continue;
+    }
+    if (scanBinDistance(bin) != binDistance(bin)) {
+      printf("FAIL scanning: bin %u read %d mm, expected %d mm\n", bin, scanBinDistance(bin),
+             binDistance(bin));
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+static bool avoidanceCheck() {
+  settle();
+  setAvoidMode(AvoidMode::Alternate);
+  fixedDistance = 2000;
+  if (!start(RobotMotionId::AutoWalking)) {
+    printf("FAIL avoidance: auto walking did not start\n");
+    return false;
+  }
+  const unsigned long begin = clockMs;
+  // 在前半个周期打断，恢复时不能从后半个周期的入口进入
+  while (clockMs - begin < 500 || sharedCounter % 8 != 1) {
+    step();
+    if (clockMs - begin > LIMIT_MS) {
+      printf("FAIL avoidance: auto walking did not advance\n");
+      return false;
+    }
+  }
+
+  // 障碍读数排在最前，之后的位置都已占满：自动行走处理读数时发布的事件只剩一个空位
+  publishEvent(RobotEventType::DistanceMeasured, 0, AVOID_DISTANCE_MM / 2);
+  while (publishEvent(RobotEventType::PhaseAdvanced, static_cast<uint8_t>(RobotMotionId::Idle))) {
+  }
+  step();
+  bool ok = true;
+  if (currentMotionId != RobotMotionId::TurningLeft &&
+      currentMotionId != RobotMotionId::TurningRight) {
+    printf("FAIL avoidance: no turn after an obstacle reading behind a full queue\n");
+    ok = false;
+  }
+  // 转向完成后恢复自动行走
+  const unsigned long turned = clockMs;
+  while (currentMotionId != RobotMotionId::AutoWalking ||
+         currentMotionState != RobotMotionState::InProgress) {
+    step();
+    if (clockMs - turned > LIMIT_MS) {
+      printf("FAIL avoidance: auto walking did not resume\n");
+      fixedDistance = 0;
+      return false;
+    }
+  }
+  // 恢复后走完一个周期，每个髋关节都要动过
+  int16_t resumed[4];
+  bool moved[4] = {false, false, false, false};
+  for (uint8_t leg = 0; leg < 4; leg++) {
+    resumed[leg] = servoEstimatedDeci(BodyLayout::servo(leg, 0));
+  }
+  const uint16_t cycleEnd = (sharedCounter / 8 + 1) * 8;
+  const unsigned long walked = clockMs;
+  while (sharedCounter < cycleEnd && clockMs - walked < LIMIT_MS) {
+    step();
+    for (uint8_t leg = 0; leg < 4; leg++) {
+      moved[leg] = moved[leg] || servoEstimatedDeci(BodyLayout::servo(leg, 0)) != resumed[leg];
+    }
+  }
+  for (uint8_t leg = 0; leg < 4; leg++) {
+    if (!moved[leg]) {
+      printf("FAIL avoidance: hip %u did not move in the first cycle after resuming\n", leg);
+      ok = false;
+    }
+  }
+  fixedDistance = 0;
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (std::string(argv[i]) == "-v") {
+      verbose = true;
+    } else {
+      fprintf(stderr, "usage: scripttest [-v]\n");
+      return 2;
+    }
+  }
+  memset(EEPROM.data, 0xFF, sizeof(EEPROM.data));
+  freeRunning = true;
+  setup();
+  freeRunning = false;
+  // 髋关节不修剪，估计位置就是动作设置的角度
+  trimLoader.set(BodyLayout::servo(0, 0), 0);
+  reverseLoader.set(BodyLayout::servo(0, 0), false);
+  refreshServoMapping();
+
+  int passed = 0, failed = 0;
+  for (bool (*check)() : {singingCheck, scanningCheck, avoidanceCheck}) {
+    if (check()) {
+      passed++;
+    } else {
+      failed++;
+    }
+  }
+  printf("scripttest: %d passed, %d failed\n", passed, failed);
+  return failed == 0 ? 0 : 1;
+}